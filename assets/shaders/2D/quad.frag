@@ -1,10 +0,0 @@
-#version 330 core
-
-in vec4 f_color;
-
-out vec4 FragColor;
-
-void main()
-{
-    FragColor = f_color;
-}
\ No newline at end of file
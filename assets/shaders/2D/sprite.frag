@@ -0,0 +1,26 @@
+#version 330 core
+
+in vec2 f_sdf;
+in vec2 f_uv;
+flat in float f_radius;
+flat in vec4 f_color;
+flat in int f_shape;
+flat in int f_texture;
+
+out vec4 FragColor;
+
+uniform sampler2DArray sprite_textures;
+
+#define SHAPE_CIRCLE 1
+
+void main() {
+    float weight = 1.0;
+    if (f_shape == SHAPE_CIRCLE) {
+        weight = f_radius - length(f_sdf);
+        weight = smoothstep(-0.9, 0.9, weight);
+    }
+    vec4 color = f_color;
+    if (f_texture > 0)
+        color = color * texture(sprite_textures, vec3(f_uv, f_texture - 1));
+    FragColor = vec4(color.rgb, color.a * weight);
+}
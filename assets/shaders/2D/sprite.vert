@@ -0,0 +1,53 @@
+#version 330 core
+
+// per instance, the sprite is a triangle strip generated from gl_VertexID
+layout (location = 0) in vec2 v_position;
+layout (location = 1) in vec2 v_size;
+layout (location = 2) in vec4 v_color;
+// shape, layer + 128, texture layer + 1 (0 = none), unused
+layout (location = 3) in uvec4 v_info;
+// left, bottom, right, top
+layout (location = 4) in vec4 v_uv;
+
+out vec2 f_sdf;
+out vec2 f_uv;
+flat out float f_radius;
+flat out vec4 f_color;
+flat out int f_shape;
+flat out int f_texture;
+
+uniform mat4 projectionview;
+uniform vec2 resolution;
+
+#define SHAPE_QUAD 0
+#define SHAPE_CIRCLE 1
+#define AA_pad 4
+
+void main() {
+    // (0, 0), (0, 1), (1, 0), (1, 1)
+    vec2 dir = vec2(gl_VertexID >> 1, gl_VertexID & 1);
+    int shape = int(v_info.x);
+    // the camera looks at z in (-1, 1), larger z is closer
+    float depth = (float(v_info.y) - 128.0) / 128.0;
+    f_color = v_color;
+    f_shape = shape;
+    f_texture = int(v_info.z);
+    f_uv = mix(v_uv.xy, v_uv.zw, dir);
+
+    if (shape == SHAPE_CIRCLE) {
+        // position is the center, size.x the radius
+        dir = 2.0 * dir - 1.0;
+        vec4 origin = projectionview * vec4(v_position, depth, 1);
+        vec4 clip_pos = origin + projectionview * vec4(v_size.x * dir, 0, 0);
+        clip_pos.xy = clip_pos.xy + AA_pad * dir / resolution;
+        gl_Position = clip_pos;
+
+        f_sdf = resolution * (clip_pos.xy - origin.xy);
+        f_radius = min(resolution.x, resolution.y) * v_size.x;
+    } else {
+        // position is the bottom left corner
+        gl_Position = projectionview * vec4(v_position + v_size * dir, depth, 1);
+        f_sdf = vec2(0);
+        f_radius = 1.0;
+    }
+}
@@ -49,7 +49,7 @@ SET compilerFlags=-g -Wall
 :: Werror - this causes errors for included c files
 SET includeFlags=-Isrc -Idependencies/entt/src -Idependencies/glad/include -Idependencies/glfw/include -Idependencies/glm -Idependencies/imgui -Idependencies/stb
 SET linkerDirs=-Ldependencies/glfw/build/src/Debug
-SET linkerFlags=-lglfw3dll -lopengl32 
+SET linkerFlags=-lglfw3dll -lopengl32 -lws2_32 
 REM SET defines=
 
 ECHO "Building $assembly..."
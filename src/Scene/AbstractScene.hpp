@@ -1,28 +1,244 @@
 #pragma once
 
+#include <functional>
+#include <type_traits>
+#include <vector>
+
 #include "Entity.hpp"
+#include "callbacks.hpp"
+#include "Snapshot.hpp"
+#include "SystemScheduler.hpp"
 
 class AbstractScene {
 protected:
+    // declared before the registry so they outlive it (signals, ctx pointers)
+    CommandBuffer m_commands;
+    StringInterner m_names;
+    NameIndex m_name_index;
+    Callback::Registry m_callbacks;
+    SceneSerializer m_serializer;
+    // declared groups and signal connections, redone when the registry gets
+    // replaced
+    std::vector<std::function<void(entt::registry&)>> m_registry_setup;
+
     entt::registry m_registry;
+    SystemScheduler m_systems;
 
 public:
-    // registry has a default constructor so this should be fine
-    AbstractScene() = default;
+    AbstractScene() {
+        connect_registry();
+    }
     // registry is stack allocated so this should be fine
     ~AbstractScene() = default;
 
-    Entity create_entity(std::string name = "N/A") {
+    Entity create_entity(std::string_view name = "N/A") {
         Entity e = Entity(m_registry, m_registry.create());
-        e.add<Component::Name>(name);
+        e.add<Component::Name>(m_names.intern(name));
+        return e;
+    }
+
+    // Same as create_entity() but only created by the next flush_commands(),
+    // for callbacks and systems iterating the registry
+    DeferredEntity create_deferred_entity(std::string_view name = "N/A") {
+        DeferredEntity e = m_commands.create();
+        e.add<Component::Name>(m_names.intern(name));
         return e;
     }
 
+    // Names
+
+    uint32_t intern(std::string_view name) {
+        return m_names.intern(name);
+    }
+
+    const std::string& get_name(uint32_t id) const {
+        return m_names.get(id);
+    }
+
+    // First entity with the given name or an invalid entity
+    Entity find_entity(std::string_view name) {
+        uint32_t id = m_names.find(name);
+        if (id == StringInterner::INVALID)
+            return Entity(m_registry, entt::null);
+        return Entity(m_registry, m_name_index.find(m_registry, id));
+    }
+
+    std::vector<entt::entity> find_entities(std::string_view name) {
+        uint32_t id = m_names.find(name);
+        if (id == StringInterner::INVALID)
+            return {};
+        return m_name_index.find_all(m_registry, id);
+    }
+
+    // Creates `count` entities with default constructed Components in bulk
+    // and then calls init(i, components&...) for each of them. Tag (empty)
+    // components have no data to initialize, insert those with 
+    // registry.insert<Tag>(entities.begin(), entities.end()) instead.
+    template <typename... Components, typename Init>
+    std::vector<entt::entity> spawn_batch(size_t count, Init&& init) {
+        static_assert(!(std::is_empty_v<Components> || ...), "Tag components can't be passed to init.");
+
+        std::vector<entt::entity> entities(count);
+        m_registry.create(entities.begin(), entities.end());
+        (insert_defaults<Components>(entities), ...);
+        init_batch(entities, init, m_registry.storage<Components>()...);
+        return entities;
+    }
+
     entt::registry& get_registry() {
         return m_registry;
     }
 
+    CommandBuffer& get_commands() {
+        return m_commands;
+    }
+
+    Callback::Registry& get_callbacks() {
+        return m_callbacks;
+    }
+
+    // Applies deferred creates/adds/removes/destroys
+    void flush_commands() {
+        m_commands.flush(m_registry);
+    }
+
+    // Systems (see SystemScheduler.hpp)
+
+    template <typename... R, typename... W>
+    void add_system(
+            const std::string& name, System::Reads<R...> reads, System::Writes<W...> writes, 
+            std::function<void(float)> function, System::Phase phase = System::Phase::Update
+        ) {
+        m_systems.add(name, reads, writes, std::move(function), phase);
+    }
+
+    // Calls function(delta_time, entity, components&...) for every entity in
+    // view<Components...>, e.g. for simple per component updates. Reads and
+    // writes follow the constness of Components. Changes to the structure of
+    // the registry need to go through the CommandBuffer.
+    template <typename... Components, typename Function>
+    void add_each_system(const std::string& name, Function function, System::Phase phase = System::Phase::Update) {
+        static_assert(!(std::is_empty_v<Components> || ...), "Tag components are not passed to function, use a view in add_system.");
+        m_systems.add_view<Components...>(name, [this, function](float delta_time){
+            m_registry.view<Components...>().each([&](entt::entity e, Components&... components){
+                function(delta_time, e, components...);
+            });
+        }, phase);
+    }
+
+    void add_exclusive_system(const std::string& name, std::function<void(float)> function, System::Phase phase = System::Phase::Update) {
+        m_systems.add_exclusive(name, std::move(function), phase);
+    }
+
+    void remove_system(const std::string& name) {
+        m_systems.remove(name);
+    }
+
+    void run_systems(float delta_time) {
+        m_systems.run(m_registry, delta_time);
+    }
+
     virtual void clear() {
+        m_commands.clear();
         m_registry.clear();
     }
+
+    // Groups
+
+    // Owning groups keep their owned components packed in the same order,
+    // so iterating them skips the sparse set lookups of a view. A component
+    // can only be owned by one group. Declared groups exist for the lifetime
+    // of the scene (also after restoring snapshots), so systems can fetch
+    // them concurrently with registry.group<Owned...>(entt::get<Get...>).
+    template <typename... Owned, typename... Get, typename... Exclude>
+    void declare_group(entt::get_t<Get...> = entt::get_t<Get...>{}, entt::exclude_t<Exclude...> = entt::exclude_t<Exclude...>{}) {
+        add_registry_setup([](entt::registry& registry){ 
+            registry.group<Owned...>(entt::get<Get...>, entt::exclude<Exclude...>); 
+        });
+    }
+
+    // Calls setup(registry) now and whenever the registry gets replaced
+    // (restoring snapshots), e.g. to connect signals
+    void add_registry_setup(std::function<void(entt::registry&)> setup) {
+        setup(m_registry);
+        m_registry_setup.push_back(std::move(setup));
+    }
+
+    // Snapshots (see Snapshot.hpp)
+
+    // Components need to be registered to be included in snapshots, Size
+    // is their sizeof for the current SceneSerializer::VERSION
+    template <typename Component, size_t Size>
+    void add_snapshot_component() {
+        m_serializer.add_component<Component, Size>();
+    }
+
+    std::vector<uint8_t> take_snapshot() const {
+        std::vector<uint8_t> output;
+        m_serializer.save(m_registry, m_names, output);
+        return output;
+    }
+
+    // Replaces the current registry content with the snapshot. If the
+    // snapshot is invalid the scene stays as it is.
+    bool restore_snapshot(const uint8_t* data, size_t size) {
+        // entt's loader wants a fresh registry, clear() keeps destroyed
+        // entities around. Signals and groups get set up once it's complete.
+        entt::registry registry;
+        if (!m_serializer.load(registry, m_names, data, size))
+            return false;
+
+        m_commands.clear();
+        m_registry = std::move(registry);
+        connect_registry();
+        m_systems.invalidate();
+        return true;
+    }
+
+    bool restore_snapshot(const std::vector<uint8_t>& snapshot) {
+        return restore_snapshot(snapshot.data(), snapshot.size());
+    }
+
+    bool save_snapshot(const std::string& filepath) const {
+        return SceneSerializer::write_file(filepath, take_snapshot());
+    }
+
+    bool load_snapshot(const std::string& filepath) {
+        MappedFile file;
+        if (!file.open(filepath)) {
+            std::cout << "Failed to open " << filepath << std::endl;
+            return false;
+        }
+        return restore_snapshot(file.data(), file.size());
+    }
+
+private:
+    void connect_registry() {
+        // so entities can find the command buffer, names and callbacks
+        m_registry.ctx().emplace<CommandBuffer*>(&m_commands);
+        m_registry.ctx().emplace<StringInterner*>(&m_names);
+        m_registry.ctx().emplace<Callback::Registry*>(&m_callbacks);
+
+        m_registry.on_construct<Component::Name>().connect<&NameIndex::mark_dirty>(m_name_index);
+        m_registry.on_update<Component::Name>().connect<&NameIndex::mark_dirty>(m_name_index);
+        m_registry.on_destroy<Component::Name>().connect<&NameIndex::mark_dirty>(m_name_index);
+        m_name_index.mark_dirty(m_registry, entt::null);
+        TransformHierarchy::connect(m_registry);
+
+        for (auto& setup : m_registry_setup)
+            setup(m_registry);
+    }
+
+    template <typename Component>
+    void insert_defaults(const std::vector<entt::entity>& entities) {
+        auto& storage = m_registry.storage<Component>();
+        storage.reserve(storage.size() + entities.size());
+        m_registry.insert<Component>(entities.begin(), entities.end());
+    }
+
+    template <typename Init, typename... Storages>
+    static void init_batch(const std::vector<entt::entity>& entities, Init& init, Storages&... storages) {
+        for (size_t i = 0; i < entities.size(); i++)
+            init(i, storages.get(entities[i])...);
+    }
 };
\ No newline at end of file
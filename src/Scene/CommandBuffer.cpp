@@ -0,0 +1,38 @@
+#include "CommandBuffer.hpp"
+
+void CommandBuffer::flush(entt::registry& registry) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(m_recording, m_flushing);
+    }
+    Batch& batch = *m_flushing;
+
+    // creates
+    m_created.resize(batch.create_count);
+    if (!m_created.empty())
+        registry.create(m_created.begin(), m_created.end());
+
+    // adds & removes, one pool at a time
+    for (size_t i = 0; i < batch.pools.size(); i++)
+        if (batch.pool_used[i])
+            batch.pools[i]->flush(registry, m_created);
+
+    // destroys
+    if (!batch.destroys.empty()) {
+        std::vector<entt::entity>& destroys = batch.destroys;
+        std::sort(destroys.begin(), destroys.end());
+        destroys.erase(std::unique(destroys.begin(), destroys.end()), destroys.end());
+        destroys.erase(
+            std::remove_if(destroys.begin(), destroys.end(), [&registry](entt::entity e){ return !registry.valid(e); }),
+            destroys.end()
+        );
+        registry.destroy(destroys.begin(), destroys.end());
+    }
+
+    batch.clear();
+}
+
+void CommandBuffer::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_recording->clear();
+}
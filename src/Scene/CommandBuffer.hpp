@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "core/FrameArena.hpp"
+#include "core/Metrics.hpp"
+
+// Records structural registry changes (create, add, remove, destroy) from any
+// thread and applies them later, at a sync point, via flush(). Changes are
+// grouped by component type so each pool gets one bulk insert/remove rather
+// than many small ones. This makes it safe to change the registry from
+// callbacks and systems which are iterating views.
+//
+// A flush applies, in order:
+// 1. creates
+// 2. adds and removes, per component type in the order they were first used
+// 3. destroys
+// Adding a component an entity already has replaces it. If an entity gets
+// both adds and removes of a component, the one recorded last wins. Commands
+// targeting entities which are no longer valid are dropped.
+
+class CommandBuffer;
+
+// Handle to an entity which will be created on the next flush
+class DeferredEntity {
+private:
+    CommandBuffer* m_buffer = nullptr;
+    uint32_t m_index = 0;
+
+public:
+    DeferredEntity() = default;
+    DeferredEntity(CommandBuffer* buffer, uint32_t index) : m_buffer(buffer), m_index(index) {}
+
+    template <typename Component, typename... Args>
+    void add(Args&&... args) const;
+
+    uint32_t get_index() const { return m_index; }
+};
+
+class CommandBuffer {
+private:
+    // Either an existing entity or the index of a deferred create
+    struct Target {
+        entt::entity entity = entt::null;
+        uint32_t deferred = UINT32_MAX;
+
+        entt::entity resolve(const std::vector<entt::entity>& created) const {
+            return deferred == UINT32_MAX ? entity : created[deferred];
+        }
+    };
+
+    struct AbstractPool {
+        virtual ~AbstractPool() = default;
+        virtual void flush(entt::registry& registry, const std::vector<entt::entity>& created) = 0;
+        virtual void clear() = 0;
+    };
+
+    template <typename Component>
+    struct Pool : AbstractPool {
+        std::vector<Target> add_targets;
+        std::vector<Component> add_values;
+        std::vector<Target> remove_targets;
+        // recording order of the adds and removes
+        std::vector<uint32_t> add_order;
+        std::vector<uint32_t> remove_order;
+        uint32_t next_order = 0;
+
+        void flush(entt::registry& registry, const std::vector<entt::entity>& created) override {
+            auto& storage = registry.storage<Component>();
+
+            // scratch space, (entity, order) of the last add/remove per
+            // entity are sorted
+            FrameVector<std::pair<entt::entity, size_t>> fresh(FrameArena::get().allocator());
+            FrameVector<entt::entity> entities(FrameArena::get().allocator());
+            FrameVector<Component> values(FrameArena::get().allocator());
+            FrameVector<std::pair<entt::entity, uint32_t>> last_adds(FrameArena::get().allocator());
+            FrameVector<std::pair<entt::entity, uint32_t>> last_removes(FrameArena::get().allocator());
+
+            // an add and a remove of the same entity cancel out unless
+            // recorded after the other
+            if (!add_targets.empty() && !remove_targets.empty()) {
+                collect_last(registry, created, add_targets, add_order, last_adds);
+                collect_last(registry, created, remove_targets, remove_order, last_removes);
+            }
+
+            if (!add_targets.empty()) {
+                // Entities which already have the component get it replaced,
+                // the rest get bulk inserted.
+                fresh.reserve(add_targets.size());
+                for (size_t i = 0; i < add_targets.size(); i++) {
+                    entt::entity e = add_targets[i].resolve(created);
+                    if (!registry.valid(e) || (last_order(last_removes, e) > add_order[i]))
+                        continue;
+                    if (storage.contains(e)) {
+                        if constexpr (!std::is_empty_v<Component>)
+                            registry.replace<Component>(e, std::move(add_values[i]));
+                    } else
+                        fresh.emplace_back(e, i);
+                }
+
+                // If an entity was added to multiple times the last value wins
+                std::stable_sort(fresh.begin(), fresh.end(), [](const auto& a, const auto& b){
+                    return a.first < b.first;
+                });
+                entities.reserve(fresh.size());
+                for (size_t i = 0; i < fresh.size(); i++) {
+                    if ((i + 1 < fresh.size()) && (fresh[i].first == fresh[i + 1].first))
+                        continue;
+                    entities.push_back(fresh[i].first);
+                    if constexpr (!std::is_empty_v<Component>)
+                        values.push_back(std::move(add_values[fresh[i].second]));
+                }
+
+                storage.reserve(storage.size() + entities.size());
+                if constexpr (std::is_empty_v<Component>)
+                    registry.insert<Component>(entities.begin(), entities.end());
+                else
+                    registry.insert<Component>(entities.begin(), entities.end(), values.begin());
+            }
+
+            if (!remove_targets.empty()) {
+                entities.clear();
+                for (size_t i = 0; i < remove_targets.size(); i++) {
+                    entt::entity e = remove_targets[i].resolve(created);
+                    if (registry.valid(e) && (last_order(last_adds, e) < remove_order[i]))
+                        entities.push_back(e);
+                }
+                registry.remove<Component>(entities.begin(), entities.end());
+            }
+        }
+
+        void clear() override {
+            add_targets.clear();
+            add_values.clear();
+            remove_targets.clear();
+            add_order.clear();
+            remove_order.clear();
+            next_order = 0;
+        }
+
+        static void collect_last(entt::registry& registry, const std::vector<entt::entity>& created, 
+            const std::vector<Target>& targets, const std::vector<uint32_t>& order, 
+            FrameVector<std::pair<entt::entity, uint32_t>>& output) 
+        {
+            output.reserve(targets.size());
+            for (size_t i = 0; i < targets.size(); i++) {
+                entt::entity e = targets[i].resolve(created);
+                if (registry.valid(e))
+                    output.emplace_back(e, order[i]);
+            }
+            // the last entry per entity has the highest order
+            std::sort(output.begin(), output.end());
+        }
+
+        // order of the last command for `e`, 0 if there is none (orders start at 1)
+        static uint32_t last_order(const FrameVector<std::pair<entt::entity, uint32_t>>& last, entt::entity e) {
+            auto it = std::upper_bound(last.begin(), last.end(), std::make_pair(e, UINT32_MAX));
+            if ((it == last.begin()) || (std::prev(it)->first != e))
+                return 0;
+            return std::prev(it)->second;
+        }
+    };
+
+    struct Batch {
+        uint32_t create_count = 0;
+        std::vector<entt::entity> destroys;
+        // pools in order of first use
+        std::vector<std::unique_ptr<AbstractPool>> pools;
+        std::unordered_map<entt::id_type, size_t> pool_index;
+        std::vector<bool> pool_used;
+
+        template <typename Component>
+        Pool<Component>& get_pool() {
+            entt::id_type id = entt::type_hash<Component>::value();
+            auto it = pool_index.find(id);
+            size_t idx;
+            if (it == pool_index.end()) {
+                idx = pools.size();
+                pool_index[id] = idx;
+                pools.emplace_back(std::make_unique<Pool<Component>>());
+                pool_used.push_back(false);
+            } else {
+                idx = it->second;
+            }
+            pool_used[idx] = true;
+            return static_cast<Pool<Component>&>(*pools[idx]);
+        }
+
+        void clear() {
+            create_count = 0;
+            destroys.clear();
+            for (size_t i = 0; i < pools.size(); i++) {
+                pools[i]->clear();
+                pool_used[i] = false;
+            }
+        }
+    };
+
+    std::mutex m_mutex;
+    // commands get recorded into m_recording while m_flushing is applied
+    Batch m_batches[2];
+    Batch* m_recording = &m_batches[0];
+    Batch* m_flushing = &m_batches[1];
+    std::vector<entt::entity> m_created;
+
+    Metrics::Counter& m_commands = Metrics::counter("CommandBuffer/commands");
+
+public:
+    CommandBuffer() = default;
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    // The command buffer of a scene lives in the registry context
+    static CommandBuffer& get(entt::registry& registry) {
+        return *registry.ctx().get<CommandBuffer*>();
+    }
+
+    DeferredEntity create() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.add();
+        return DeferredEntity(this, m_recording->create_count++);
+    }
+
+    template <typename Component, typename... Args>
+    void add(entt::entity entity, Args&&... args) {
+        Target target;
+        target.entity = entity;
+        push_add<Component>(target, std::forward<Args>(args)...);
+    }
+
+    template <typename Component, typename... Args>
+    void add(DeferredEntity entity, Args&&... args) {
+        Target target;
+        target.deferred = entity.get_index();
+        push_add<Component>(target, std::forward<Args>(args)...);
+    }
+
+    template <typename Component>
+    void remove(entt::entity entity) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.add();
+        Target target;
+        target.entity = entity;
+        Pool<Component>& pool = m_recording->get_pool<Component>();
+        pool.remove_targets.push_back(target);
+        pool.remove_order.push_back(++pool.next_order);
+    }
+
+    void destroy(entt::entity entity) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.add();
+        m_recording->destroys.push_back(entity);
+    }
+
+    // Applies all recorded commands. Must not run concurrently with anything
+    // else using the registry. Commands recorded during the flush (e.g. from
+    // entt signals) are applied on the next flush.
+    void flush(entt::registry& registry);
+
+    // Drops all recorded commands
+    void clear();
+
+private:
+    // aggregates need brace init in C++17 (same as entt::registry::emplace)
+    template <typename Component, typename... Args>
+    static Component make(Args&&... args) {
+        if constexpr (std::is_aggregate_v<Component>)
+            return Component{std::forward<Args>(args)...};
+        else
+            return Component(std::forward<Args>(args)...);
+    }
+
+    template <typename Component, typename... Args>
+    void push_add(Target target, Args&&... args) {
+        // construct outside the lock
+        Component component = make<Component>(std::forward<Args>(args)...);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.add();
+        Pool<Component>& pool = m_recording->get_pool<Component>();
+        pool.add_targets.push_back(target);
+        pool.add_values.push_back(std::move(component));
+        pool.add_order.push_back(++pool.next_order);
+    }
+};
+
+template <typename Component, typename... Args>
+void DeferredEntity::add(Args&&... args) const {
+    m_buffer->add<Component>(*this, std::forward<Args>(args)...);
+}
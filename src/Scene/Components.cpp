@@ -1,8 +1,8 @@
 #include "Components.hpp"
 #include <glm/gtx/io.hpp>
 
-std::ostream& operator<<(std::ostream& stream, Component::Name& comp) {
-    stream << "Name(" << comp.name << ")";
+std::ostream& operator<<(std::ostream& stream, Component::Name comp) {
+    stream << "Name(#" << comp.id << ")";
     return stream;
 }
 
@@ -14,6 +14,11 @@ std::ostream& operator<<(std::ostream& stream, Component::Transform& comp) {
     return stream;
 }
 
+std::ostream& operator<<(std::ostream& stream, Component::Transform2D& comp) {
+    stream << "Transform2D(position = " << comp.position << ", scale = " << 
+        comp.scale << ", angle = " << comp.angle << ")";
+    return stream;
+}
 
 std::ostream& operator<<(std::ostream& stream, Component::Circle comp) {
     stream << "Circle(color = " << comp.color << ")";
@@ -21,7 +26,7 @@ std::ostream& operator<<(std::ostream& stream, Component::Circle comp) {
 }
 
 std::ostream& operator<<(std::ostream& stream, Component::Quad comp) {
-    stream << "Quad(color = " << comp.color << ")";
+    stream << "Quad(color = " << comp.color << ", texture = " << (int) comp.texture.layer << ")";
     return stream;
 }
 
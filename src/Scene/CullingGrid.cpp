@@ -0,0 +1,125 @@
+#include "CullingGrid.hpp"
+
+#include <algorithm>
+
+template <typename Component>
+static void connect_component(entt::registry& registry, CullingGrid& grid) {
+    registry.on_construct<Component>().template connect<&CullingGrid::mark_dirty>(grid);
+    registry.on_destroy<Component>().template connect<&CullingGrid::mark_dirty>(grid);
+}
+
+template <typename Component>
+static void disconnect_component(entt::registry& registry, CullingGrid& grid) {
+    registry.on_construct<Component>().disconnect(&grid);
+    registry.on_destroy<Component>().disconnect(&grid);
+}
+
+void CullingGrid::connect(entt::registry& registry) {
+    connect_component<Component::Static>(registry, *this);
+    connect_component<Component::Transform2D>(registry, *this);
+    connect_component<Component::Quad>(registry, *this);
+    connect_component<Component::Circle>(registry, *this);
+    m_reset = true;
+}
+
+void CullingGrid::disconnect(entt::registry& registry) {
+    disconnect_component<Component::Static>(registry, *this);
+    disconnect_component<Component::Transform2D>(registry, *this);
+    disconnect_component<Component::Quad>(registry, *this);
+    disconnect_component<Component::Circle>(registry, *this);
+}
+
+void CullingGrid::update(entt::registry& registry) {
+    if (m_reset) {
+        m_grid.clear();
+        m_items.clear();
+        m_free.clear();
+        m_quads.clear();
+        m_circles.clear();
+        m_dirty.clear();
+        auto quads = registry.view<Component::Quad>();
+        auto circles = registry.view<Component::Circle>();
+        m_dirty.assign(quads.begin(), quads.end());
+        m_dirty.insert(m_dirty.end(), circles.begin(), circles.end());
+        m_reset = false;
+    }
+
+    if (!m_dirty.empty()) {
+        // an entity may have been marked by multiple signals
+        std::sort(m_dirty.begin(), m_dirty.end());
+        m_dirty.erase(std::unique(m_dirty.begin(), m_dirty.end()), m_dirty.end());
+
+        for (entt::entity e : m_dirty) {
+            bool dynamic = registry.valid(e) &&
+                registry.all_of<Component::Transform2D>(e) &&
+                !registry.all_of<Component::Static>(e);
+            sync(registry, e, dynamic && registry.all_of<Component::Quad>(e), false);
+            sync(registry, e, dynamic && registry.all_of<Component::Circle>(e), true);
+        }
+        m_dirty.clear();
+    }
+
+    const auto& transforms = registry.storage<Component::Transform2D>();
+    uint64_t moved = 0;
+    for (const Item& item : m_items) {
+        if (item.entity == entt::null)
+            continue;
+        const Component::Transform2D& transform = transforms.get(item.entity);
+        glm::vec4 box = item.circle ? circle_box(transform) : quad_box(transform);
+        if (box != m_grid.box(item.grid_item)) {
+            m_grid.move(item.grid_item, box);
+            moved++;
+        }
+    }
+    m_moved.add(moved);
+}
+
+void CullingGrid::query(entt::registry& registry, glm::vec4 lrbt, FrameVector<entt::entity>& quads, FrameVector<entt::entity>& circles) {
+    m_grid.query(lrbt, [&](uint32_t id){
+        const Item& item = m_items[id];
+        (item.circle ? circles : quads).push_back(item.entity);
+    });
+
+    // owning groups keep their entities at the front of the owned storage,
+    // in group order
+    const auto& quad_storage = registry.storage<Component::Quad>();
+    const auto& circle_storage = registry.storage<Component::Circle>();
+    std::sort(quads.begin(), quads.end(), [&quad_storage](entt::entity a, entt::entity b){
+        return quad_storage.index(a) < quad_storage.index(b);
+    });
+    std::sort(circles.begin(), circles.end(), [&circle_storage](entt::entity a, entt::entity b){
+        return circle_storage.index(a) < circle_storage.index(b);
+    });
+}
+
+void CullingGrid::sync(entt::registry& registry, entt::entity e, bool in_group, bool circle) {
+    auto& entities = circle ? m_circles : m_quads;
+    auto it = entities.find(e);
+
+    if (!in_group) {
+        if (it != entities.end()) {
+            m_grid.remove(m_items[it->second].grid_item);
+            m_items[it->second].entity = entt::null;
+            m_free.push_back(it->second);
+            entities.erase(it);
+        }
+        return;
+    }
+    if (it != entities.end())
+        return;
+
+    uint32_t id;
+    if (!m_free.empty()) {
+        id = m_free.back();
+        m_free.pop_back();
+    } else {
+        id = (uint32_t) m_items.size();
+        m_items.emplace_back();
+    }
+    const Component::Transform2D& transform = registry.get<Component::Transform2D>(e);
+    Item& item = m_items[id];
+    item.entity = e;
+    item.circle = circle;
+    item.grid_item = m_grid.insert(id, circle ? circle_box(transform) : quad_box(transform));
+    entities.emplace(e, id);
+}
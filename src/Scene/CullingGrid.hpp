@@ -0,0 +1,70 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "Components.hpp"
+#include "SpatialGrid2D.hpp"
+#include "StaticSprites.hpp"
+#include "core/FrameArena.hpp"
+#include "core/Metrics.hpp"
+
+// Persistent SpatialGrid2D over the dynamic (not Static) quads and circles
+// Scene2D renders. Membership changes are collected from registry signals
+// and applied on update(). Transform2D gets written through references
+// (e.g. Physics2D), so update() compares every box with the one in the grid
+// and only moves those that differ.
+class CullingGrid {
+private:
+    struct Item {
+        entt::entity entity = entt::null;
+        uint32_t grid_item = 0;
+        bool circle = false;
+    };
+
+    SpatialGrid2D m_grid;
+    // grid ids index m_items, free ones have a null entity
+    std::vector<Item> m_items;
+    std::vector<uint32_t> m_free;
+    // entity -> index in m_items
+    std::unordered_map<entt::entity, uint32_t> m_quads;
+    std::unordered_map<entt::entity, uint32_t> m_circles;
+    std::vector<entt::entity> m_dirty;
+    // registry got replaced, items are stale
+    bool m_reset = true;
+
+    Metrics::Counter& m_moved = Metrics::counter("CullingGrid/moved");
+
+public:
+    void connect(entt::registry& registry);
+    void disconnect(entt::registry& registry);
+
+    void mark_dirty(entt::registry&, entt::entity e) {
+        m_dirty.push_back(e);
+    }
+
+    // Adds and removes entities that changed, moves the ones that moved
+    void update(entt::registry& registry);
+
+    // Entities overlapping lrbt, each list in the order of its render group
+    // so overlapping sprites don't flicker
+    void query(entt::registry& registry, glm::vec4 lrbt, FrameVector<entt::entity>& quads, FrameVector<entt::entity>& circles);
+
+    size_t size() const { return m_quads.size() + m_circles.size(); }
+
+    // quads start at position, circles are centered
+    static glm::vec4 quad_box(const Component::Transform2D& transform) {
+        const glm::vec2 p = transform.position, s = transform.scale;
+        return glm::vec4(p.x, p.x + s.x, p.y, p.y + s.y);
+    }
+    static glm::vec4 circle_box(const Component::Transform2D& transform) {
+        const glm::vec2 p = transform.position;
+        const float r = transform.scale.x;
+        return glm::vec4(p.x - r, p.x + r, p.y - r, p.y + r);
+    }
+
+private:
+    void sync(entt::registry& registry, entt::entity e, bool in_group, bool circle);
+};
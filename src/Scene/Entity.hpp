@@ -4,6 +4,9 @@
 #include <iostream>
 
 #include "Components.hpp"
+#include "CommandBuffer.hpp"
+#include "Names.hpp"
+#include "Hierarchy.hpp"
 #include "core/logging.hpp"
 
 class Entity {
@@ -61,6 +64,27 @@ public:
         return m_registry->all_of<Component...>(m_entity);
     }
 
+    // Names are interned per scene
+    const std::string& get_name() const {
+        if (!has<Component::Name>())
+            return m_registry->ctx().get<StringInterner*>()->get(0);
+        return m_registry->ctx().get<StringInterner*>()->get(get<Component::Name>().id);
+    }
+
+    void set_name(std::string_view name) const {
+        uint32_t id = m_registry->ctx().get<StringInterner*>()->intern(name);
+        m_registry->emplace_or_replace<Component::Name>(m_entity, id);
+    }
+
+    // Makes this entities Transform relative to the parent
+    void set_parent(const Entity& parent) const {
+        m_registry->emplace_or_replace<Component::Parent>(m_entity, parent.m_entity);
+    }
+
+    void remove_parent() const {
+        m_registry->remove<Component::Parent>(m_entity);
+    }
+
     entt::entity get_entity() const {
         return m_entity;
     }
@@ -69,9 +93,21 @@ public:
         m_registry->destroy(m_entity);
     }
 
+    // Deferred versions of add/remove/destroy. These get applied when the
+    // scene flushes its CommandBuffer and are safe to use while iterating.
+    // Scheduling both an add and a remove of a component, the later one wins.
+    template <typename Component, typename... Args>
+    void schedule_add(Args&&... args) const {
+        CommandBuffer::get(*m_registry).add<Component>(m_entity, std::forward<Args>(args)...);
+    }
+
+    template <typename Component>
+    void schedule_remove() const {
+        CommandBuffer::get(*m_registry).remove<Component>(m_entity);
+    }
+
     void schedule_delete() const {
-        if (!has<Component::ScheduledDelete>())
-            m_registry->emplace<Component::ScheduledDelete>(m_entity);
+        CommandBuffer::get(*m_registry).destroy(m_entity);
     }
 
     friend inline bool operator==(const Entity& e1, const Entity& e2) {
@@ -0,0 +1,139 @@
+#include "Hierarchy.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "core/FrameArena.hpp"
+
+void TransformHierarchy::connect(entt::registry& registry) {
+    registry.on_construct<Component::Parent>().connect<&TransformHierarchy::invalidate>();
+    registry.on_update<Component::Parent>().connect<&TransformHierarchy::invalidate>();
+    registry.on_destroy<Component::Parent>().connect<&TransformHierarchy::invalidate>();
+}
+
+void TransformHierarchy::invalidate(entt::registry& registry, entt::entity entity) {
+    if (Component::WorldMatrix* world = registry.try_get<Component::WorldMatrix>(entity))
+        world->valid = false;
+}
+
+void TransformHierarchy::update_depths(entt::registry& registry) {
+    // Depths are computed by walking up to the first ancestor with a known
+    // depth (or a root), then assigning them on the way back down. Every
+    // entity is visited once, whatever order the storage is in.
+    static const uint32_t UNKNOWN = 0, VISITING = UINT32_MAX;
+    auto& parents = registry.storage<Component::Parent>();
+    const size_t count = parents.size();
+    FrameVector<uint32_t> depths(count, UNKNOWN, FrameArena::get().allocator());
+    FrameVector<size_t> chain(FrameArena::get().allocator());
+    bool changed = false;
+
+    for (size_t i = 0; i < count; i++) {
+        chain.clear();
+        uint32_t depth = 0;
+        size_t idx = i;
+        while (true) {
+            if (depths[idx] == VISITING) {
+                assert(false && "Parent cycle");
+                std::cout << "Parent cycle, treating entity " << entt::to_integral(parents.data()[idx]) << " as a root" << std::endl;
+                break;
+            }
+            if (depths[idx] != UNKNOWN) {
+                depth = depths[idx];
+                break;
+            }
+            depths[idx] = VISITING;
+            chain.push_back(idx);
+            entt::entity parent = parents.get(parents.data()[idx]).entity;
+            if (!parents.contains(parent))
+                break;
+            idx = parents.index(parent);
+        }
+
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            depths[*it] = ++depth;
+            Component::Parent& parent = parents.get(parents.data()[*it]);
+            if (parent.depth != depth) {
+                parent.depth = depth;
+                changed = true;
+            }
+        }
+    }
+
+    if (changed)
+        registry.sort<Component::Parent>([](const Component::Parent& a, const Component::Parent& b){
+            return a.depth < b.depth;
+        });
+}
+
+static void copy_local(const Component::Transform& transform, Component::WorldMatrix& world) {
+    world.position = transform.position;
+    world.rotation = transform.rotation;
+    world.scale = transform.scale;
+    world.valid = true;
+}
+
+void TransformHierarchy::update(entt::registry& registry, TransformBatch& batch) {
+    {
+        auto view = registry.view<Component::Transform>(entt::exclude<Component::WorldMatrix>);
+        FrameVector<entt::entity> missing(view.begin(), view.end(), FrameArena::get().allocator());
+        registry.insert<Component::WorldMatrix>(missing.begin(), missing.end());
+    }
+
+    update_depths(registry);
+
+    // local matrices for everything, packed in group order
+    auto group = registry.group<Component::Transform, Component::WorldMatrix>();
+    batch.update(registry, group);
+
+    auto& parents = registry.storage<Component::Parent>();
+    auto& transforms = registry.storage<Component::Transform>();
+    auto& worlds = registry.storage<Component::WorldMatrix>();
+
+    // roots, local == world
+    {
+        const entt::entity* entities = transforms.data();
+        for (size_t i = 0; i < group.size(); i++) {
+            if (parents.contains(entities[i]))
+                continue;
+
+            const Component::Transform& transform = transforms.get(entities[i]);
+            Component::WorldMatrix& world = worlds.get(entities[i]);
+            world.changed = !world.matches(transform);
+            if (!world.changed)
+                continue;
+
+            world.model = batch[i].model;
+            world.normal = batch[i].get_normalmatrix();
+            copy_local(transform, world);
+        }
+    }
+
+    // children, parents before children
+    for (auto [e, parent] : parents.each()) {
+        if (!transforms.contains(e))
+            continue;
+
+        const size_t i = transforms.index(e);
+        const Component::Transform& transform = transforms.get(e);
+        Component::WorldMatrix& world = worlds.get(e);
+        const Component::WorldMatrix* parent_world = worlds.contains(parent.entity) ? &worlds.get(parent.entity) : nullptr;
+
+        world.changed = !world.matches(transform) || (parent_world && parent_world->changed);
+        if (world.changed) {
+            world.model = batch[i].model;
+            world.normal = batch[i].get_normalmatrix();
+            if (parent_world) {
+                world.model = parent_world->model * world.model;
+                world.normal = parent_world->normal * world.normal;
+            }
+            copy_local(transform, world);
+        }
+
+        // batch should hold world matrices too
+        batch[i].model = world.model;
+        batch[i].normal[0] = glm::vec4(world.normal[0], 0.0f);
+        batch[i].normal[1] = glm::vec4(world.normal[1], 0.0f);
+        batch[i].normal[2] = glm::vec4(world.normal[2], 0.0f);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+#include "Components.hpp"
+#include "TransformBatch.hpp"
+
+namespace Component {
+    // Makes the Transform of an entity relative to the parent entity
+    struct Parent {
+        entt::entity entity = entt::null;
+        // distance to the root, maintained by TransformHierarchy
+        uint32_t depth = 1;
+
+        Parent() = default;
+        Parent(const Parent&) = default;
+        Parent(entt::entity e) : entity(e) {}
+    };
+
+    // Cached world space matrices, maintained by TransformHierarchy
+    struct WorldMatrix {
+        glm::mat4 model = glm::mat4(1.0f);
+        glm::mat3 normal = glm::mat3(1.0f);
+
+        // local transform the matrices were computed from
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 scale = glm::vec3(1.0f);
+        bool valid = false;
+        // recomputed this frame, children need to update too
+        bool changed = false;
+
+        bool matches(const Transform& transform) const {
+            return valid && (position == transform.position) &&
+                (rotation == transform.rotation) && (scale == transform.scale);
+        }
+    };
+}
+
+// Computes WorldMatrix for every entity with a Transform. Local matrices are
+// computed in bulk by TransformBatch over the owning group<Transform,
+// WorldMatrix>. WorldMatrix components (and parent multiplications) are only
+// updated if the local Transform or one of the ancestors changed. Children
+// are kept sorted by depth, so this is a single pass over roots followed by a
+// single pass over children.
+// Afterwards `batch` holds the world matrices of all entities in group order.
+class TransformHierarchy {
+public:
+    // Adds missing WorldMatrix components, so this is a structural change
+    static void update(entt::registry& registry, TransformBatch& batch);
+
+    // Recomputes the world matrix of an entity whose parent changed (the
+    // Transform didn't, so it would look up to date). Children follow.
+    // connect() does this for every added, replaced or removed Parent.
+    static void connect(entt::registry& registry);
+    static void invalidate(entt::registry& registry, entt::entity entity);
+
+private:
+    static void update_depths(entt::registry& registry);
+};
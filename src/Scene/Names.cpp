@@ -0,0 +1,60 @@
+#include "Names.hpp"
+#include "Components.hpp"
+
+// StringInterner
+
+uint32_t StringInterner::intern(std::string_view str) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_ids.find(str);
+    if (it != m_ids.end())
+        return it->second;
+
+    uint32_t id = (uint32_t) m_strings.size();
+    m_strings.emplace_back(str);
+    m_ids[m_strings.back()] = id;
+    return id;
+}
+
+uint32_t StringInterner::find(std::string_view str) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_ids.find(str);
+    return it == m_ids.end() ? INVALID : it->second;
+}
+
+const std::string& StringInterner::get(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return id < m_strings.size() ? m_strings[id] : m_strings.front();
+}
+
+size_t StringInterner::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_strings.size();
+}
+
+// NameIndex
+
+void NameIndex::rebuild(entt::registry& registry) {
+    m_index.clear();
+    auto view = registry.view<Component::Name>();
+    m_index.reserve(view.size());
+    for (entt::entity e : view)
+        m_index.emplace(view.get<Component::Name>(e).id, e);
+    m_dirty = false;
+}
+
+entt::entity NameIndex::find(entt::registry& registry, uint32_t id) {
+    if (m_dirty)
+        rebuild(registry);
+    auto it = m_index.find(id);
+    return it == m_index.end() ? entt::null : it->second;
+}
+
+std::vector<entt::entity> NameIndex::find_all(entt::registry& registry, uint32_t id) {
+    if (m_dirty)
+        rebuild(registry);
+    std::vector<entt::entity> output;
+    auto range = m_index.equal_range(id);
+    for (auto it = range.first; it != range.second; ++it)
+        output.push_back(it->second);
+    return output;
+}
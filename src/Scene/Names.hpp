@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+// Entity names are stored once per scene and referenced through a 4 byte id
+// in Component::Name. Id 0 is always the empty string.
+
+class StringInterner {
+private:
+    mutable std::mutex m_mutex;
+    // deque so string_views into it stay valid
+    std::deque<std::string> m_strings;
+    std::unordered_map<std::string_view, uint32_t> m_ids;
+
+public:
+    static const uint32_t INVALID = UINT32_MAX;
+
+    StringInterner() { intern(""); }
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    // Returns the id of `str`, adding it if it doesn't exist yet
+    uint32_t intern(std::string_view str);
+    // Returns the id of `str` or INVALID
+    uint32_t find(std::string_view str) const;
+    const std::string& get(uint32_t id) const;
+
+    size_t size() const;
+};
+
+// name -> entity lookup for debugging/tools. This gets marked dirty by the
+// Name signals and rebuilt on the next lookup.
+class NameIndex {
+private:
+    std::unordered_multimap<uint32_t, entt::entity> m_index;
+    bool m_dirty = true;
+
+public:
+    void mark_dirty(entt::registry&, entt::entity) { m_dirty = true; }
+
+    // first entity with the given name id or entt::null
+    entt::entity find(entt::registry& registry, uint32_t id);
+    // all entities with the given name id
+    std::vector<entt::entity> find_all(entt::registry& registry, uint32_t id);
+
+private:
+    void rebuild(entt::registry& registry);
+};
@@ -1,15 +1,34 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 
 #include "AbstractScene.hpp"
+#include "CullingGrid.hpp"
+#include "SpriteBatchBuilder.hpp"
+#include "StaticSprites.hpp"
 #include "callbacks.hpp"
+#include "core/FrameArena.hpp"
+#include "core/Metrics.hpp"
+#include "core/RenderThread.hpp"
 #include "renderer/Renderer2D.hpp"
 #include "camera/Camera2D.hpp"
 
 // TODO: 
 // Move definitions to cpp file
 
+namespace Component {
+    // Destroys the entity once |x| or |y| exceeds limit
+    struct OutOfBounds {
+        float limit = 1.1f;
+
+        OutOfBounds() = default;
+        OutOfBounds(const OutOfBounds&) = default;
+        OutOfBounds(float l) : limit(l) {}
+    };
+}
+
 class Scene2D : public AbstractScene {
 private:
     struct ScreenShake {
@@ -41,80 +60,189 @@ private:
     };
 
     Renderer2D m_renderer;
+    RenderQueue m_queue;
+    StaticSprites m_static_sprites;
+    SpriteBatchBuilder m_batch_builder;
     Camera2D m_camera;
     ScreenShake m_shake;
 
+    bool m_culling = true;
+    CullingGrid m_culling_grid;
+
+    Metrics::Counter& m_culled = Metrics::counter("Scene2D/culled");
+    Metrics::Counter& m_submitted = Metrics::counter("Scene2D/submitted");
+    Metrics::Gauge& m_alive = Metrics::gauge("Scene2D/entities alive");
+
 public:
 
     Scene2D() : 
         m_renderer(Renderer2D()), 
         m_camera(Camera2D(-1.0f, 1.0f, -1.0f, 1.0f))
-    {}
+    {
+        add_each_system<const Component::Transform2D, const Component::OutOfBounds>("Scene2D/out of bounds", 
+            [this](float, entt::entity e, const Component::Transform2D& transform, const Component::OutOfBounds& bounds){
+                if ((std::abs(transform.position.x) > bounds.limit) || (std::abs(transform.position.y) > bounds.limit))
+                    m_commands.destroy(e);
+            }
+        );
+        // callbacks may do anything so these need the registry to themselves
+        add_exclusive_system("Scene2D/on update", [this](float){ resolve_on_update(); }, System::Phase::PostUpdate);
+        add_exclusive_system("Scene2D/flush commands", [this](float){ flush_commands(); }, System::Phase::PostUpdate);
+        // after the collisions that trigger it, so the shake starts this frame
+        add_system("Scene2D/screen shake", System::Reads<>(), System::Writes<>(), 
+            [this](float delta_time){ m_shake.update(delta_time); }, System::Phase::PostUpdate
+        );
+
+        // render loops, Transform2D is owned by Physics2D
+        declare_group<Component::Quad>(entt::get<Component::Transform2D>, entt::exclude<Component::Static>);
+        declare_group<Component::Circle>(entt::get<Component::Transform2D>, entt::exclude<Component::Static>);
+        add_registry_setup([this](entt::registry& registry){ m_static_sprites.connect(registry); });
+        add_registry_setup([this](entt::registry& registry){ m_culling_grid.connect(registry); });
+
+        add_snapshot_component<Component::Name, 4>();
+        add_snapshot_component<Component::Transform2D, 20>();
+        add_snapshot_component<Component::Quad, 36>();
+        add_snapshot_component<Component::Circle, 16>();
+        add_snapshot_component<Component::OnUpdate, 4>();
+        add_snapshot_component<Component::OutOfBounds, 4>();
+        add_snapshot_component<Component::Static, 1>();
+
+        // fields can move without changing the size, update these with the
+        // next SceneSerializer::VERSION bump
+        static_assert(SceneSerializer::VERSION == 2, "Check the snapshot layouts below.");
+        static_assert(offsetof(Component::Quad, texture) == 16, "Quad changed, bump SceneSerializer::VERSION.");
+        static_assert(offsetof(Component::SpriteTexture, uv) == 4, "SpriteTexture changed, bump SceneSerializer::VERSION.");
+    }
+
+    ~Scene2D() {
+        m_static_sprites.disconnect(m_registry);
+        m_culling_grid.disconnect(m_registry);
+    }
 
     void init() {
         m_renderer.init();
     }
 
+    // see Renderer2D::load_texture
+    Component::SpriteTexture load_texture(const std::string& filepath) {
+        return m_renderer.load_texture(filepath);
+    }
+
     // Entity Constructors:
 
     Entity create_circle() {
-        return create_circle(glm::vec3(0), 0.1f);
+        return create_circle(glm::vec2(0), 0.1f);
     }
 
-    Entity create_circle(glm::vec3 pos, float r, glm::vec4 color = glm::vec4(0.8, 0.3, 0, 1)) {
+    Entity create_circle(glm::vec2 pos, float r, glm::vec4 color = glm::vec4(0.8, 0.3, 0, 1)) {
         return create_circle("Circle Entity", pos, r, color);
     };
 
-    Entity create_circle(std::string name, glm::vec3 pos, float r, glm::vec4 color = glm::vec4(0.8, 0.3, 0, 1)) {
+    Entity create_circle(std::string_view name, glm::vec2 pos, float r, glm::vec4 color = glm::vec4(0.8, 0.3, 0, 1)) {
         Entity entity = create_entity(name);
 
         entity.add<Component::Circle>(color); 
-        entity.add<Component::Transform>(pos, glm::vec3(r, r, 1));
+        entity.add<Component::Transform2D>(pos, glm::vec2(r, r));
 
         return entity;
     };
 
+    // Deferred versions, see create_deferred_entity()
+    DeferredEntity create_deferred_circle(std::string_view name, glm::vec2 pos, float r, glm::vec4 color = glm::vec4(0.8, 0.3, 0, 1)) {
+        DeferredEntity entity = create_deferred_entity(name);
+        entity.add<Component::Circle>(color);
+        entity.add<Component::Transform2D>(pos, glm::vec2(r, r));
+        return entity;
+    }
+
     Entity create_quad() {
-        return create_quad(glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec2(1.0f, 1.0f));
+        return create_quad(glm::vec2(-0.5f, -0.5f), glm::vec2(1.0f, 1.0f));
     }
 
-    Entity create_quad(glm::vec3 position, glm::vec2 size, glm::vec4 color = glm::vec4(0.4, 0.7, 0, 1)) {
+    Entity create_quad(glm::vec2 position, glm::vec2 size, glm::vec4 color = glm::vec4(0.4, 0.7, 0, 1)) {
         return create_quad("Quad Entity", position, size, color);
     }
 
-    Entity create_quad(std::string name, glm::vec3 position, glm::vec2 size, glm::vec4 color = glm::vec4(0.4, 0.7, 0, 1)) {
+    Entity create_quad(std::string_view name, glm::vec2 position, glm::vec2 size, glm::vec4 color = glm::vec4(0.4, 0.7, 0, 1)) {
         Entity entity = create_entity(name);
     
         entity.add<Component::Quad>(color); 
-        entity.add<Component::Transform>(position, glm::vec3(size, 1)); 
+        entity.add<Component::Transform2D>(position, size); 
+
+        return entity;
+    }
 
+    DeferredEntity create_deferred_quad(std::string_view name, glm::vec2 position, glm::vec2 size, glm::vec4 color = glm::vec4(0.4, 0.7, 0, 1)) {
+        DeferredEntity entity = create_deferred_entity(name);
+        entity.add<Component::Quad>(color);
+        entity.add<Component::Transform2D>(position, size);
         return entity;
     }
 
+    // Bulk versions, these return the created entities
+    std::vector<entt::entity> create_quads(
+            const glm::vec2* positions, size_t count, glm::vec2 size, 
+            glm::vec4 color = glm::vec4(0.4, 0.7, 0, 1), std::string_view name = "Quad Entity"
+        ) {
+        uint32_t name_id = intern(name);
+        return spawn_batch<Component::Name, Component::Quad, Component::Transform2D>(count, 
+            [&](size_t i, Component::Name& n, Component::Quad& quad, Component::Transform2D& transform){
+                n.id = name_id;
+                quad.color = color;
+                transform.position = positions[i];
+                transform.scale = size;
+            }
+        );
+    }
+
+    std::vector<entt::entity> create_quads(
+            const std::vector<glm::vec2>& positions, glm::vec2 size, 
+            glm::vec4 color = glm::vec4(0.4, 0.7, 0, 1), std::string_view name = "Quad Entity"
+        ) {
+        return create_quads(positions.data(), positions.size(), size, color, name);
+    }
+
+    std::vector<entt::entity> create_circles(
+            const glm::vec2* positions, size_t count, float r, 
+            glm::vec4 color = glm::vec4(0.8, 0.3, 0, 1), std::string_view name = "Circle Entity"
+        ) {
+        glm::vec2 scale = glm::vec2(r, r);
+        uint32_t name_id = intern(name);
+        return spawn_batch<Component::Name, Component::Circle, Component::Transform2D>(count, 
+            [&](size_t i, Component::Name& n, Component::Circle& circle, Component::Transform2D& transform){
+                n.id = name_id;
+                circle.color = color;
+                transform.position = positions[i];
+                transform.scale = scale;
+            }
+        );
+    }
+
     void screen_shake() { m_shake.reset(); }
 
+    // Skips sprites outside the camera bounds (static sprites are always drawn)
+    void set_culling(bool enabled) { m_culling = enabled; }
+    bool get_culling() const { return m_culling; }
+
     // Systems
 
     void resolve_on_update() {
         auto view = m_registry.view<Component::OnUpdate>();
         for (entt::entity e : view) {
             Entity ent = Entity(m_registry, e);
-            m_registry.get<Component::OnUpdate>(e).callback(ent);
+            m_callbacks.call(view.get<Component::OnUpdate>(e).callback, ent);
         }
     }
 
-    void resolve_scheduled_deletes() {
-        auto view = m_registry.view<Component::ScheduledDelete>();
-        m_registry.destroy(view.begin(), view.end());
-    }
-
     void update(float delta_time) {
-        m_shake.update(delta_time);
-        resolve_on_update();
-        resolve_scheduled_deletes();
+        run_systems(delta_time);
+        m_alive.set((double) m_registry.storage<entt::entity>().in_use());
     }
 
     void render(glm::vec2 resolution) {
+        static Metrics::Timer& timer = Metrics::timer("Scene2D/render");
+        Metrics::Timer::Scope scope(timer);
+
         // Fixing shorter dimension here to avoid edges +-1 being outside a standard window
         float aspect = resolution.x / resolution.y;
         if (aspect > 1)
@@ -125,27 +253,47 @@ public:
         float shake_delta = m_shake.get_delta();
         m_camera.translate_by(glm::vec3(0.0f, shake_delta, 0.0f));
 
-        m_renderer.begin(m_camera.m_projectionview, resolution);
-
-        {
-            auto view = m_registry.view<Component::Transform, Component::Quad>();
-            for (auto entity : view) {
-                auto [transform, quad] = view.get<Component::Transform, Component::Quad>(entity);
-                m_renderer.draw_quad(transform.position, transform.scale, quad.color);
+        m_static_sprites.update(m_registry, m_renderer);
+        m_queue.set_pass(RenderQueue::BLENDED, [](){
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        });
+        m_renderer.begin(m_queue, m_camera.m_projectionview, resolution);
+
+        auto quads = m_registry.group<Component::Quad>(entt::get<Component::Transform2D>, entt::exclude<Component::Static>);
+        auto circles = m_registry.group<Component::Circle>(entt::get<Component::Transform2D>, entt::exclude<Component::Static>);
+        auto make_quad = [](const Component::Quad& quad, const Component::Transform2D& transform){
+            return Renderer2D::SpriteInstance::quad(transform, quad);
+        };
+        auto make_circle = [](const Component::Circle& circle, const Component::Transform2D& transform){
+            return Renderer2D::SpriteInstance::circle(transform, circle.color);
+        };
+
+        if (m_culling) {
+            {
+                static Metrics::Timer& timer = Metrics::timer("Scene2D/update grid");
+                Metrics::Timer::Scope scope(timer);
+                m_culling_grid.update(m_registry);
             }
-        }
 
-        {
-            auto view = m_registry.view<Component::Transform, Component::Circle>();
-            for (auto entity : view) {
-                auto [transform, circle] = view.get<Component::Transform, Component::Circle>(entity);
-                // TODO: should use scale directly
-                // ... or transform matrix
-                m_renderer.draw_circle(transform.position, transform.scale.x, circle.color); 
-            }
+            FrameVector<entt::entity> visible_quads(FrameArena::get().allocator());
+            FrameVector<entt::entity> visible_circles(FrameArena::get().allocator());
+            m_culling_grid.query(m_registry, m_camera.get_lrbt(), visible_quads, visible_circles);
+
+            m_batch_builder.build<Component::Quad>(m_renderer, m_registry, visible_quads.data(), visible_quads.size(), make_quad);
+            m_batch_builder.build<Component::Circle>(m_renderer, m_registry, visible_circles.data(), visible_circles.size(), make_circle);
+            const size_t visible = visible_quads.size() + visible_circles.size();
+            m_submitted.add(visible);
+            m_culled.add(m_culling_grid.size() - visible);
+        } else {
+            m_batch_builder.build<Component::Quad>(m_renderer, m_registry, quads, make_quad);
+            m_batch_builder.build<Component::Circle>(m_renderer, m_registry, circles, make_circle);
+            m_submitted.add(quads.size() + circles.size());
         }
 
+        // drawn on the render thread while the next frame gets recorded
         m_renderer.end();
+        uint32_t frame = m_queue.close();
+        RenderThread::get().run([this, frame](){ m_queue.execute(frame); });
     }
-
 };
\ No newline at end of file
@@ -2,11 +2,14 @@
 
 #include <vector>
 #include <array>
+#include <cstring>
 
 #include <glm/gtx/io.hpp>
 
 #include "AbstractScene.hpp"
 #include "callbacks.hpp"
+#include "core/Metrics.hpp"
+#include "core/RenderThread.hpp"
 
 #include "renderer/MeshRenderer.hpp"
 #include "renderer/VoxelRenderer.hpp"
@@ -39,6 +42,9 @@ private:
     MeshRenderer m_mesh_renderer;
     VoxelRenderer m_voxel_renderer;
     VoxelRenderer2 m_voxel_renderer2;
+    RenderQueue m_queue;
+    // world matrices of everything with a Transform, packed
+    TransformBatch m_transforms;
 
     // TODO: move into new structure/class
     std::unique_ptr<GLFramebuffer> m_framebuffer = nullptr;
@@ -47,12 +53,24 @@ private:
     // Shadow pass
     OrthographicCamera m_shadow_camera;
 
+    Metrics::Gauge& m_alive = Metrics::gauge("Scene3D/entities alive");
+
 
 public:
 
     Scene3D() : 
         m_camera(FirstPersonCamera()), m_shadow_camera(OrthographicCamera())
-    {}
+    {
+        add_system("Scene3D/rotate", 
+            System::Reads<Component::Chunk>(), System::Writes<Component::Transform>(), 
+            [this](float delta_time){ rotate_transforms(delta_time); }
+        );
+        add_exclusive_system("Scene3D/on update", [this](float){ resolve_on_update(); }, System::Phase::PostUpdate);
+        add_exclusive_system("Scene3D/flush commands", [this](float){ flush_commands(); }, System::Phase::PostUpdate);
+        declare_group<Component::Transform, Component::WorldMatrix>();
+        // adds missing WorldMatrix components and sorts parents
+        add_exclusive_system("Scene3D/world matrices", [this](float){ TransformHierarchy::update(m_registry, m_transforms); }, System::Phase::PostUpdate);
+    }
 
     void init(Window* window) {
         m_window = window;
@@ -113,20 +131,20 @@ public:
         return m_camera;
     }
 
+    // Ordered like group<Transform, WorldMatrix>, can be uploaded as a per
+    // instance buffer
+    const TransformBatch& get_instance_matrices() const {
+        return m_transforms;
+    }
+
     void on_event(AbstractEvent& event) {
         dispatch<WindowResizeEvent>(BIND_EVENT_FN(on_resize), event);
         dispatch<MouseMoveEvent>(BIND_EVENT_FN(on_mouse_move), event);
     }
 
     void update(float delta_time) {
-        resolve_on_update();
-        resolve_scheduled_deletes();
-
-        auto view = m_registry.view<Component::Transform>(entt::exclude<Component::Chunk>);
-        for(entt::entity e : view) {
-            auto& transform = m_registry.get<Component::Transform>(e);
-            transform.rotate_by(glm::normalize(glm::vec3(-1.0f, 1.0f, -0.5f)), delta_time);
-        }
+        run_systems(delta_time);
+        m_alive.set((double) m_registry.storage<entt::entity>().in_use());
 
         // camera motion (keyboard)
         float step = 30.0f * delta_time;
@@ -145,12 +163,6 @@ public:
         glm::vec3 light_direction = glm::normalize(glm::vec3(0.0f, -1.0f, 0.0));
         m_camera.recalculate_view();
 
-        // Shadow pass 
-        m_framebuffer->bind();
-        glViewport(0, 0, 1024, 1024);
-        glEnable(GL_DEPTH_TEST);
-        glClear(GL_DEPTH_BUFFER_BIT);
-
         { // Setup matrix
             m_shadow_camera.viewdirection(light_direction);
             float view_distance = glm::length(m_camera.eyeposition());
@@ -159,68 +171,83 @@ public:
             m_shadow_camera.recalculate_view();
         }
 
-        {
-            auto view = m_registry.view<Component::SimpleMesh, Component::SimpleTexture2D, Component::Transform>();
-            m_mesh_renderer.begin_shadow(m_shadow_camera.m_projectionview);
-            for (entt::entity e : view)
-                m_mesh_renderer.draw_shadow_mesh(Entity(m_registry, e));
-            m_mesh_renderer.end();
-        }
+        // Everything below is recorded into m_queue and drawn by execute() on
+        // the render thread, while the next frame gets recorded
+        auto& tex = m_framebuffer->get(0);
 
-        {
-            auto view = m_registry.view<Component::Chunk, Component::Transform>();
-            m_voxel_renderer.begin_shadow(m_shadow_camera.m_projectionview);
-            for (entt::entity e : view)
-                m_voxel_renderer.render_shadow(Entity(m_registry, e));
-            m_voxel_renderer.end();
+        { // render passes
+            GLFramebuffer* framebuffer = m_framebuffer.get();
+            glm::ivec2 window_size = m_window->get_window_size();
+            m_queue.set_pass(RenderQueue::SHADOW, [framebuffer](){
+                framebuffer->bind();
+                glViewport(0, 0, 1024, 1024);
+                glEnable(GL_DEPTH_TEST);
+                glClear(GL_DEPTH_BUFFER_BIT);
+            });
+            m_queue.set_pass(RenderQueue::GEOMETRY, [framebuffer, window_size](){
+                framebuffer->unbind();
+                glViewport(0, 0, window_size.x, window_size.y);
+                glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                glEnable(GL_DEPTH_TEST);
+                // glEnable(GL_MULTISAMPLE);
+            });
         }
 
-        m_framebuffer->unbind();
-
-        // Main Pass
-        glm::ivec2 window_size = m_window->get_window_size();
-        glViewport(0, 0, window_size.x, window_size.y);
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-        // glEnable(GL_MULTISAMPLE);
-
-        m_camera.recalculate_view();
-        auto& tex = m_framebuffer->get(0);
-
-        // Render meshes
         {
-            auto view = m_registry.view<Component::SimpleMesh, Component::SimpleTexture2D, Component::Transform>();
-            m_mesh_renderer.begin(m_camera.m_projectionview);
-            GLShader& shader = m_mesh_renderer.get_shader();
-            shader.set_uniform("shadowmap", tex);
-            shader.set_uniform("lightspace", m_shadow_camera.m_projectionview);
-            for (entt::entity e : view)
+            auto view = m_registry.view<Component::SimpleMesh, Component::SimpleTexture2D, Component::WorldMatrix>();
+            m_mesh_renderer.begin_shadow(m_queue, m_shadow_camera.m_projectionview);
+            m_mesh_renderer.begin(m_queue, m_camera.m_projectionview, m_camera.eyeposition());
+            m_mesh_renderer.set_shadows(tex, m_shadow_camera.m_projectionview);
+            for (entt::entity e : view) {
+                m_mesh_renderer.draw_shadow_mesh(Entity(m_registry, e));
                 m_mesh_renderer.draw_mesh(Entity(m_registry, e));
-            m_mesh_renderer.end();
+            }
         }
 
         {
-            auto view = m_registry.view<Component::Chunk, Component::Transform>();
-            m_voxel_renderer.begin(m_camera.m_projectionview);
-            GLShader& shader = m_voxel_renderer.get_shader();
-            shader.set_uniform("shadowmap", tex);
-            shader.set_uniform("lightspace", m_shadow_camera.m_projectionview);
-            for (entt::entity e : view)
+            auto view = m_registry.view<Component::Chunk, Component::WorldMatrix>();
+            m_voxel_renderer.begin_shadow(m_queue, m_shadow_camera.m_projectionview);
+            m_voxel_renderer.begin(m_queue, m_camera.m_projectionview, m_camera.eyeposition());
+            m_voxel_renderer.set_shadows(tex, m_shadow_camera.m_projectionview);
+            for (entt::entity e : view) {
+                m_voxel_renderer.render_shadow(Entity(m_registry, e));
                 m_voxel_renderer.render(Entity(m_registry, e));
-            m_voxel_renderer.end();
+            }
         }
 
-        {
+        { // not a queue client yet, runs as one packet per world
             auto view = m_registry.view<Component::VoxelWorld>();
-
-            m_voxel_renderer2.begin(m_camera.m_projectionview, m_camera.eyeposition());
-            for (entt::entity e : view)
-                m_voxel_renderer2.render(Entity(m_registry, e));
-            m_voxel_renderer2.end();
+            const VoxelRenderer2* renderer = &m_voxel_renderer2;
+            glm::mat4 projectionview = m_camera.m_projectionview;
+            glm::vec3 eyeposition = m_camera.eyeposition();
+            for (entt::entity e : view) {
+                auto& world = view.get<Component::VoxelWorld>(e);
+                // the world may change or go away before the queue executes
+                const uint8_t* upload = nullptr;
+                if (world.needs_update) {
+                    const size_t bytes = (size_t) world.size.x * world.size.y * world.size.z;
+                    uint8_t* copy = m_queue.allocate<uint8_t>(bytes);
+                    std::memcpy(copy, world.data, bytes);
+                    upload = copy;
+                }
+                world.needs_update = false;
+                m_queue.submit(RenderQueue::GEOMETRY, nullptr, UINT32_MAX, 
+                    [renderer, projectionview, eyeposition, upload, size = world.size](GLShader*){
+                        renderer->begin(projectionview, eyeposition);
+                        if (upload)
+                            renderer->update_world(upload, size);
+                        renderer->render(size);
+                        renderer->end();
+                    }
+                );
+            }
         }
 
-        skybox->render(m_camera.m_view, m_camera.m_projection);
+        skybox->render(m_queue, m_camera.m_view, m_camera.m_projection);
+
+        uint32_t frame = m_queue.close();
+        RenderThread::get().run([this, frame](){ m_queue.execute(frame); });
 
         // copy to screen
         // m_framebuffer->unbind();
@@ -241,19 +268,22 @@ public:
 
 private:
     // Systems
+    void rotate_transforms(float delta_time) {
+        auto view = m_registry.view<Component::Transform>(entt::exclude<Component::Chunk>);
+        for(entt::entity e : view) {
+            auto& transform = m_registry.get<Component::Transform>(e);
+            transform.rotate_by(glm::normalize(glm::vec3(-1.0f, 1.0f, -0.5f)), delta_time);
+        }
+    }
+
     void resolve_on_update() {
         auto view = m_registry.view<Component::OnUpdate>();
         for (entt::entity e : view) {
             Entity ent = Entity(m_registry, e);
-            m_registry.get<Component::OnUpdate>(e).callback(ent);
+            m_callbacks.call(view.get<Component::OnUpdate>(e).callback, ent);
         }
     }
 
-    void resolve_scheduled_deletes() {
-        auto view = m_registry.view<Component::ScheduledDelete>();
-        m_registry.destroy(view.begin(), view.end());
-    }
-
     void on_resize(WindowResizeEvent& e) {
         m_camera.m_aspect = (float) e.size.x / (float) e.size.y;
         m_camera.recalculate_projection();
@@ -0,0 +1,204 @@
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "Snapshot.hpp"
+#include "Components.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+// MappedFile
+
+bool MappedFile::open(const std::string& filepath) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = (size_t) size.QuadPart;
+#else
+    int file = ::open(filepath.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED) {
+        ::close(file);
+        return false;
+    }
+
+    m_file = file;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = (size_t) info.st_size;
+#endif
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (!m_data)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle((HANDLE) m_mapping);
+    CloseHandle((HANDLE) m_file);
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    munmap((void*) m_data, m_size);
+    ::close(m_file);
+    m_file = -1;
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+// SceneSerializer
+
+void SceneSerializer::save(const entt::registry& registry, const StringInterner& names, std::vector<uint8_t>& output) const {
+    SnapshotWriter writer(output);
+    writer.write("GLPS", 4);
+    writer(VERSION);
+
+    uint32_t string_count = (uint32_t) names.size();
+    writer(string_count);
+    for (uint32_t i = 0; i < string_count; i++) {
+        const std::string& str = names.get(i);
+        uint32_t length = (uint32_t) str.size();
+        writer(length);
+        writer.write(str.data(), length);
+    }
+
+    entt::snapshot snapshot(registry);
+    snapshot.get<entt::entity>(writer);
+
+    uint32_t component_count = (uint32_t) m_components.size();
+    writer(component_count);
+    for (const ComponentEntry& entry : m_components) {
+        writer(entry.id);
+        writer(entry.size);
+        entry.save(snapshot, writer);
+    }
+}
+
+bool SceneSerializer::load(entt::registry& registry, StringInterner& names, const uint8_t* data, size_t size) const {
+    SnapshotReader reader(data, size);
+
+    char magic[4];
+    uint32_t version = 0;
+    reader.read(magic, 4);
+    reader(version);
+    if (reader.failed() || std::memcmp(magic, "GLPS", 4) != 0) {
+        std::cout << "Not a valid snapshot." << std::endl;
+        return false;
+    }
+    if (version != VERSION) {
+        std::cout << "Snapshot version " << version << " is not compatible with version " << VERSION << "." << std::endl;
+        return false;
+    }
+
+    // Strings may have different ids in this scene, e.g. when loading a save
+    // file in a fresh process
+    uint32_t string_count = 0;
+    reader(string_count);
+    std::vector<uint32_t> remap;
+    bool identity = true;
+    for (uint32_t i = 0; (i < string_count) && !reader.failed(); i++) {
+        uint32_t length = 0;
+        reader(length);
+        const uint8_t* chars = reader.skip(length);
+        if (!chars)
+            break;
+        remap.push_back(names.intern(std::string_view((const char*) chars, length)));
+        identity = identity && (remap.back() == i);
+    }
+
+    entt::snapshot_loader loader(registry);
+    loader.get<entt::entity>(reader);
+
+    uint32_t component_count = 0;
+    reader(component_count);
+    if (reader.failed() || component_count != m_components.size()) {
+        std::cout << "Snapshot components don't match the scene." << std::endl;
+        return false;
+    }
+
+    for (const ComponentEntry& entry : m_components) {
+        entt::id_type id = 0;
+        uint32_t component_size = 0;
+        reader(id);
+        reader(component_size);
+        if (reader.failed() || id != entry.id || component_size != entry.size) {
+            std::cout << "Snapshot components don't match the scene." << std::endl;
+            return false;
+        }
+        entry.load(loader, reader);
+    }
+
+    if (reader.failed()) {
+        std::cout << "Snapshot is truncated." << std::endl;
+        return false;
+    }
+
+    if (!identity) {
+        for (auto [e, name] : registry.view<Component::Name>().each())
+            name.id = name.id < remap.size() ? remap[name.id] : 0;
+    }
+
+    return true;
+}
+
+bool SceneSerializer::write_file(const std::string& filepath, const std::vector<uint8_t>& data) {
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cout << "Failed to open " << filepath << std::endl;
+        return false;
+    }
+    file.write((const char*) data.data(), data.size());
+    return file.good();
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "Names.hpp"
+
+// Binary scene snapshots built on entt::snapshot and entt::snapshot_loader.
+//
+// Components are written back to back into one contiguous byte buffer with
+// memcpy, so only trivially copyable components can be snapshotted. (Things
+// like callbacks are stored as ids, see Callback::Registry.) The same bytes
+// are used for in-memory checkpoints and save files. Files are loaded through
+// a memory mapping.
+//
+// Layout:
+//     "GLPS", version
+//     interned strings: count, (length, chars)...
+//     entities (entt)
+//     per component: type hash, sizeof, components (entt)
+
+// Appends raw bytes to a buffer
+class SnapshotWriter {
+private:
+    std::vector<uint8_t>& m_data;
+
+public:
+    SnapshotWriter(std::vector<uint8_t>& data) : m_data(data) {}
+
+    template <typename T>
+    void operator()(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Snapshot components must be trivially copyable.");
+        write(&value, sizeof(T));
+    }
+
+    void write(const void* data, size_t size) {
+        size_t offset = m_data.size();
+        m_data.resize(offset + size);
+        std::memcpy(m_data.data() + offset, data, size);
+    }
+};
+
+// Reads raw bytes from a buffer. Reads past the end fail and zero the output.
+class SnapshotReader {
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+    bool m_failed = false;
+
+public:
+    SnapshotReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    template <typename T>
+    void operator()(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Snapshot components must be trivially copyable.");
+        read(&value, sizeof(T));
+    }
+
+    bool read(void* data, size_t size) {
+        if (m_failed || (m_offset + size > m_size)) {
+            m_failed = true;
+            std::memset(data, 0, size);
+            return false;
+        }
+        std::memcpy(data, m_data + m_offset, size);
+        m_offset += size;
+        return true;
+    }
+
+    // returns a pointer into the buffer and skips `size` bytes
+    const uint8_t* skip(size_t size) {
+        if (m_failed || (m_offset + size > m_size)) {
+            m_failed = true;
+            return nullptr;
+        }
+        const uint8_t* ptr = m_data + m_offset;
+        m_offset += size;
+        return ptr;
+    }
+
+    bool failed() const { return m_failed; }
+};
+
+// Read-only memory mapped file
+class MappedFile {
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_file = -1;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& filepath);
+    void close();
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+};
+
+// Knows which components to (de)serialize and how
+class SceneSerializer {
+public:
+    // Bump whenever the layout of a snapshot component changes. Components
+    // are registered with their size for this version, so a size change
+    // doesn't compile until the version and the size are updated.
+    // 2: Quad has a SpriteTexture
+    static constexpr uint32_t VERSION = 2;
+
+private:
+
+    struct ComponentEntry {
+        entt::id_type id;
+        uint32_t size;
+        std::function<void(const entt::snapshot&, SnapshotWriter&)> save;
+        std::function<void(entt::snapshot_loader&, SnapshotReader&)> load;
+    };
+
+    std::vector<ComponentEntry> m_components;
+
+public:
+    template <typename Component, size_t Size>
+    void add_component() {
+        static_assert(sizeof(Component) == Size, "Snapshot component layout changed, bump SceneSerializer::VERSION and update its size.");
+        entt::id_type id = entt::type_hash<Component>::value();
+        for (const ComponentEntry& entry : m_components)
+            if (entry.id == id)
+                return;
+
+        ComponentEntry entry;
+        entry.id = id;
+        entry.size = (uint32_t) sizeof(Component);
+        entry.save = [](const entt::snapshot& snapshot, SnapshotWriter& writer){
+            snapshot.get<Component>(writer);
+        };
+        entry.load = [](entt::snapshot_loader& loader, SnapshotReader& reader){
+            loader.get<Component>(reader);
+        };
+        m_components.push_back(std::move(entry));
+    }
+
+    // Appends a snapshot of `registry` to `output`
+    void save(const entt::registry& registry, const StringInterner& names, std::vector<uint8_t>& output) const;
+    // Loads a snapshot into an empty `registry`. Returns false if the data
+    // doesn't match the registered components, `registry` may be partially
+    // filled then.
+    bool load(entt::registry& registry, StringInterner& names, const uint8_t* data, size_t size) const;
+
+    static bool write_file(const std::string& filepath, const std::vector<uint8_t>& data);
+};
@@ -0,0 +1,97 @@
+#include "SpatialGrid2D.hpp"
+
+void SpatialGrid2D::clear() {
+    size_t used = 0;
+    for (auto& [key, items] : m_cells) {
+        used += !items.empty();
+        items.clear();
+    }
+    // forget cells once most of them are stale, e.g. after scrolling
+    if ((m_cells.size() > 4096) && (m_cells.size() > 4 * used))
+        m_cells.clear();
+    m_cell_count.set((double) used);
+
+    m_boxes.clear();
+    m_ids.clear();
+    m_large.clear();
+    m_free.clear();
+}
+
+void SpatialGrid2D::reserve(size_t items) {
+    m_boxes.reserve(items);
+    m_ids.reserve(items);
+}
+
+uint32_t SpatialGrid2D::insert(uint32_t id, glm::vec4 lrbt) {
+    uint32_t item;
+    if (!m_free.empty()) {
+        item = m_free.back();
+        m_free.pop_back();
+        m_boxes[item] = lrbt;
+        m_ids[item] = id;
+    } else {
+        item = (uint32_t) m_boxes.size();
+        m_boxes.push_back(lrbt);
+        m_ids.push_back(id);
+        if (m_stamps.size() < m_boxes.size())
+            m_stamps.resize(m_boxes.capacity(), 0);
+    }
+
+    add_to_cells(item, lrbt);
+    return item;
+}
+
+void SpatialGrid2D::move(uint32_t item, glm::vec4 lrbt) {
+    if (cell_range(lrbt) != cell_range(m_boxes[item])) {
+        remove_from_cells(item, m_boxes[item]);
+        add_to_cells(item, lrbt);
+    }
+    m_boxes[item] = lrbt;
+}
+
+void SpatialGrid2D::remove(uint32_t item) {
+    remove_from_cells(item, m_boxes[item]);
+    m_free.push_back(item);
+}
+
+void SpatialGrid2D::add_to_cells(uint32_t item, glm::vec4 lrbt) {
+    if (is_large(lrbt)) {
+        m_large.push_back(item);
+        return;
+    }
+
+    glm::ivec4 range = cell_range(lrbt);
+    for (int y = range.z; y <= range.w; y++)
+        for (int x = range.x; x <= range.y; x++)
+            m_cells[key(x, y)].push_back(item);
+}
+
+// order within a cell doesn't matter
+static void swap_remove(std::vector<uint32_t>& items, uint32_t item) {
+    auto it = std::find(items.begin(), items.end(), item);
+    if (it != items.end()) {
+        *it = items.back();
+        items.pop_back();
+    }
+}
+
+void SpatialGrid2D::remove_from_cells(uint32_t item, glm::vec4 lrbt) {
+    if (is_large(lrbt)) {
+        swap_remove(m_large, item);
+        return;
+    }
+
+    glm::ivec4 range = cell_range(lrbt);
+    for (int y = range.z; y <= range.w; y++) {
+        for (int x = range.x; x <= range.y; x++) {
+            auto it = m_cells.find(key(x, y));
+            if (it == m_cells.end())
+                continue;
+            swap_remove(it->second, item);
+            // empty cells are kept for reuse, unless there are lots of them
+            // (see clear())
+            if (it->second.empty() && (m_cells.size() > 4096))
+                m_cells.erase(it);
+        }
+    }
+}
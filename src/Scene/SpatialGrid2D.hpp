@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "core/Metrics.hpp"
+
+// Uniform grid over unbounded 2D space, e.g. for culling and collision
+// broadphases. Cells are hashed, so only occupied cells cost memory.
+// Items are axis aligned boxes (left, right, bottom, top) with an id, e.g.
+// an index into an entity or box array. Boxes are added to every cell they
+// overlap. Very large ones (more than MAX_CELLS cells) go into a list that
+// every query checks instead.
+// Either rebuilt (clear + insert) whenever things moved, or kept around and
+// updated with move() and remove(). Queries are not thread safe and the grid
+// must not change during one.
+class SpatialGrid2D {
+private:
+    float m_cell_size;
+    float m_inv_cell_size;
+
+    // cell -> items, cleared cells are kept around for reuse
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+    std::vector<glm::vec4> m_boxes;
+    std::vector<uint32_t> m_ids;
+    std::vector<uint32_t> m_large;
+    // removed items, reused by insert()
+    std::vector<uint32_t> m_free;
+
+    // items already reported by the current query
+    std::vector<uint32_t> m_stamps;
+    uint32_t m_stamp = 0;
+
+    Metrics::Gauge& m_cell_count = Metrics::gauge("SpatialGrid2D/cells");
+
+public:
+    static const int MAX_CELLS = 16;
+
+    explicit SpatialGrid2D(float cell_size = 0.25f)
+        : m_cell_size(cell_size), m_inv_cell_size(1.0f / cell_size) 
+    {}
+
+    void clear();
+    void reserve(size_t items);
+    // Returns the item index for move() and remove(). Without removes items
+    // are numbered in insertion order since the last clear().
+    uint32_t insert(uint32_t id, glm::vec4 lrbt);
+    void move(uint32_t item, glm::vec4 lrbt);
+    void remove(uint32_t item);
+
+    // Calls fn(id) once for each item overlapping lrbt (touching edges don't
+    // count)
+    template <typename F>
+    void query(glm::vec4 lrbt, F&& fn) {
+        if (++m_stamp == 0) {
+            std::fill(m_stamps.begin(), m_stamps.end(), 0);
+            m_stamp = 1;
+        }
+
+        auto report = [&](uint32_t item){
+            if (m_stamps[item] == m_stamp)
+                return;
+            m_stamps[item] = m_stamp;
+            if (overlaps(m_boxes[item], lrbt))
+                fn(m_ids[item]);
+        };
+
+        for (uint32_t item : m_large)
+            report(item);
+
+        // one lookup per cell, unless there are more cells in the range
+        // than in the grid, e.g. when zoomed out
+        glm::ivec4 range = cell_range(lrbt);
+        int64_t cells = ((int64_t) range.y - range.x + 1) * ((int64_t) range.w - range.z + 1);
+        if (cells > (int64_t) m_cells.size()) {
+            for (const auto& [cell, items] : m_cells) {
+                int x = (int) (uint32_t) (cell >> 32), y = (int) (uint32_t) cell;
+                if ((x >= range.x) && (x <= range.y) && (y >= range.z) && (y <= range.w))
+                    for (uint32_t item : items)
+                        report(item);
+            }
+            return;
+        }
+        for (int y = range.z; y <= range.w; y++) {
+            for (int x = range.x; x <= range.y; x++) {
+                auto it = m_cells.find(key(x, y));
+                if (it != m_cells.end())
+                    for (uint32_t item : it->second)
+                        report(item);
+            }
+        }
+    }
+
+    size_t size() const { return m_boxes.size() - m_free.size(); }
+    glm::vec4 box(uint32_t item) const { return m_boxes[item]; }
+    float cell_size() const { return m_cell_size; }
+
+    static bool overlaps(glm::vec4 a, glm::vec4 b) {
+        return (a.x < b.y) && (a.y > b.x) && (a.z < b.w) && (a.w > b.z);
+    }
+
+private:
+    // first and last cell (x, x, y, y) touched by lrbt
+    glm::ivec4 cell_range(glm::vec4 lrbt) const {
+        return glm::ivec4(
+            (int) std::floor(lrbt.x * m_inv_cell_size), (int) std::floor(lrbt.y * m_inv_cell_size),
+            (int) std::floor(lrbt.z * m_inv_cell_size), (int) std::floor(lrbt.w * m_inv_cell_size)
+        );
+    }
+
+    bool is_large(glm::vec4 lrbt) const {
+        glm::ivec4 range = cell_range(lrbt);
+        int64_t cells = ((int64_t) range.y - range.x + 1) * ((int64_t) range.w - range.z + 1);
+        return cells > MAX_CELLS;
+    }
+
+    void add_to_cells(uint32_t item, glm::vec4 lrbt);
+    void remove_from_cells(uint32_t item, glm::vec4 lrbt);
+
+    static uint64_t key(int x, int y) {
+        return ((uint64_t) (uint32_t) x << 32) | (uint64_t) (uint32_t) y;
+    }
+};
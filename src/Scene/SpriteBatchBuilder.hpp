@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+#include <entt/entt.hpp>
+
+#include "Components.hpp"
+#include "core/JobSystem.hpp"
+#include "core/Metrics.hpp"
+#include "renderer/Renderer2D.hpp"
+
+// Builds sprites for all entities of an owning group<Owned>(get<Transform2D>)
+// straight into the mapped stream buffer of Renderer2D. The group is split
+// into chunks which fill disjoint slices of the memory on the job system,
+// the calling thread only maps and submits.
+class SpriteBatchBuilder {
+private:
+    Metrics::Timer& m_timer = Metrics::timer("SpriteBatchBuilder/build");
+    Metrics::Counter& m_built = Metrics::counter("SpriteBatchBuilder/sprites");
+
+public:
+    // sprites per job
+    static const size_t GRAIN = 4096;
+
+    // make(const Owned&, const Transform2D&) returns a Renderer2D::SpriteInstance
+    template <typename Owned, typename Group, typename Make>
+    void build(Renderer2D& renderer, entt::registry& registry, const Group& group, Make&& make) {
+        // owned storages are packed in group order
+        build<Owned>(renderer, registry, registry.storage<Owned>().data(), group.size(), make);
+    }
+
+    // Same for a list of entities which all have Owned and Transform2D
+    template <typename Owned, typename Make>
+    void build(Renderer2D& renderer, entt::registry& registry, const entt::entity* entities, size_t count, Make&& make) {
+        Metrics::Timer::Scope scope(m_timer);
+        const auto& owned = registry.storage<Owned>();
+        const auto& transforms = registry.storage<Component::Transform2D>();
+
+        for (size_t first = 0; first < count; first += Renderer2D::max_batch_size()) {
+            const size_t n = std::min(Renderer2D::max_batch_size(), count - first);
+            Renderer2D::SpriteInstance* output = renderer.map_batch(n);
+
+            std::atomic<size_t> circles = 0;
+            JobSystem::get().parallel_for(0, n, GRAIN, [&](size_t begin, size_t end){
+                size_t chunk_circles = 0;
+                for (size_t i = begin; i < end; i++) {
+                    entt::entity e = entities[first + i];
+                    // output is mapped memory, don't read it back
+                    const Renderer2D::SpriteInstance sprite = make(owned.get(e), transforms.get(e));
+                    chunk_circles += sprite.shape == Renderer2D::CIRCLE;
+                    output[i] = sprite;
+                }
+                circles.fetch_add(chunk_circles, std::memory_order_relaxed);
+            });
+
+            renderer.submit_batch(circles.load(std::memory_order_relaxed));
+        }
+        m_built.add(count);
+    }
+};
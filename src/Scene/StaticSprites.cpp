@@ -0,0 +1,77 @@
+#include "StaticSprites.hpp"
+
+#include <algorithm>
+
+template <typename Component>
+static void connect_component(entt::registry& registry, StaticSprites& sprites) {
+    registry.on_construct<Component>().template connect<&StaticSprites::mark_dirty>(sprites);
+    registry.on_update<Component>().template connect<&StaticSprites::mark_dirty>(sprites);
+    registry.on_destroy<Component>().template connect<&StaticSprites::mark_dirty>(sprites);
+}
+
+template <typename Component>
+static void disconnect_component(entt::registry& registry, StaticSprites& sprites) {
+    registry.on_construct<Component>().disconnect(&sprites);
+    registry.on_update<Component>().disconnect(&sprites);
+    registry.on_destroy<Component>().disconnect(&sprites);
+}
+
+void StaticSprites::connect(entt::registry& registry) {
+    connect_component<Component::Static>(registry, *this);
+    connect_component<Component::Transform2D>(registry, *this);
+    connect_component<Component::Quad>(registry, *this);
+    connect_component<Component::Circle>(registry, *this);
+    m_reset = true;
+}
+
+void StaticSprites::disconnect(entt::registry& registry) {
+    disconnect_component<Component::Static>(registry, *this);
+    disconnect_component<Component::Transform2D>(registry, *this);
+    disconnect_component<Component::Quad>(registry, *this);
+    disconnect_component<Component::Circle>(registry, *this);
+}
+
+void StaticSprites::update(entt::registry& registry, Renderer2D& renderer) {
+    if (m_reset) {
+        renderer.clear_static();
+        m_handles.clear();
+        m_dirty.clear();
+        auto view = registry.view<Component::Static>();
+        m_dirty.assign(view.begin(), view.end());
+        m_reset = false;
+    }
+
+    if (m_dirty.empty())
+        return;
+
+    // an entity may have been marked by multiple signals
+    std::sort(m_dirty.begin(), m_dirty.end());
+    m_dirty.erase(std::unique(m_dirty.begin(), m_dirty.end()), m_dirty.end());
+
+    for (entt::entity e : m_dirty) {
+        auto it = m_handles.find(e);
+
+        bool visible = registry.valid(e) && 
+            registry.all_of<Component::Static, Component::Transform2D>(e) && 
+            registry.any_of<Component::Quad, Component::Circle>(e);
+
+        if (!visible) {
+            if (it != m_handles.end()) {
+                renderer.remove_static(it->second);
+                m_handles.erase(it);
+            }
+            continue;
+        }
+
+        const Component::Transform2D& transform = registry.get<Component::Transform2D>(e);
+        Renderer2D::SpriteInstance sprite = registry.all_of<Component::Quad>(e) ?
+            Renderer2D::SpriteInstance::quad(transform, registry.get<Component::Quad>(e)) :
+            Renderer2D::SpriteInstance::circle(transform, registry.get<Component::Circle>(e).color);
+
+        if (it == m_handles.end())
+            m_handles.emplace(e, renderer.add_static(sprite));
+        else
+            it->second = renderer.update_static(it->second, sprite);
+    }
+    m_dirty.clear();
+}
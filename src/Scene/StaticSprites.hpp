@@ -0,0 +1,40 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "Components.hpp"
+#include "renderer/Renderer2D.hpp"
+
+namespace Component {
+    // Quads and circles of entities with this are retained by Renderer2D and
+    // only uploaded again when Transform2D, Quad or Circle get replaced or
+    // patched (Entity::set, registry.patch). Writing to them through a
+    // reference is not picked up!
+    struct Static {};
+}
+
+// Keeps the retained sprites of Renderer2D in sync with Static entities.
+// Changes are collected from registry signals and applied on update().
+class StaticSprites {
+private:
+    // entity -> Renderer2D static handle
+    std::unordered_map<entt::entity, uint32_t> m_handles;
+    std::vector<entt::entity> m_dirty;
+    // registry got replaced, handles are stale
+    bool m_reset = true;
+
+public:
+    void connect(entt::registry& registry);
+    void disconnect(entt::registry& registry);
+
+    void mark_dirty(entt::registry& registry, entt::entity e) {
+        if (registry.all_of<Component::Static>(e))
+            m_dirty.push_back(e);
+    }
+
+    // Adds, updates and removes retained sprites for everything that changed
+    void update(entt::registry& registry, Renderer2D& renderer);
+};
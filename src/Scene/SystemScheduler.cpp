@@ -0,0 +1,95 @@
+#include "SystemScheduler.hpp"
+
+#include <algorithm>
+
+#include "core/JobSystem.hpp"
+
+static bool overlaps(const std::vector<entt::id_type>& a, const std::vector<entt::id_type>& b) {
+    // these lists are tiny, no need for anything fancy
+    for (entt::id_type x : a)
+        if (std::find(b.begin(), b.end(), x) != b.end())
+            return true;
+    return false;
+}
+
+void SystemScheduler::push(SystemData&& system) {
+    system.timer = &Metrics::timer("Systems/" + system.name);
+    m_systems.push_back(std::move(system));
+    m_dirty = true;
+}
+
+void SystemScheduler::remove(const std::string& name) {
+    auto it = std::remove_if(m_systems.begin(), m_systems.end(), [&name](const SystemData& system){
+        return system.name == name;
+    });
+    m_systems.erase(it, m_systems.end());
+    m_dirty = true;
+}
+
+bool SystemScheduler::conflicts(const SystemData& a, const SystemData& b) {
+    if (a.exclusive || b.exclusive || a.phase != b.phase)
+        return true;
+    return overlaps(a.writes, b.writes) || overlaps(a.writes, b.reads) || overlaps(a.reads, b.writes);
+}
+
+void SystemScheduler::build(entt::registry& registry) {
+    // phases first, registration order second
+    std::vector<size_t> order(m_systems.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b){
+        return m_systems[a].phase < m_systems[b].phase;
+    });
+
+    // A system runs one level after the last system it conflicts with
+    std::vector<size_t> level(m_systems.size(), 0);
+    size_t max_level = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        const SystemData& system = m_systems[order[i]];
+        for (size_t j = 0; j < i; j++) {
+            if (conflicts(system, m_systems[order[j]]))
+                level[order[i]] = std::max(level[order[i]], level[order[j]] + 1);
+        }
+        max_level = std::max(max_level, level[order[i]]);
+    }
+
+    m_levels.clear();
+    if (!m_systems.empty())
+        m_levels.resize(max_level + 1);
+    for (size_t idx : order)
+        m_levels[level[idx]].push_back(idx);
+
+    for (SystemData& system : m_systems)
+        if (system.prepare)
+            system.prepare(registry);
+
+    m_dirty = false;
+}
+
+void SystemScheduler::execute(SystemData& system, float delta_time) {
+    Metrics::Timer::Scope scope(*system.timer);
+    system.function(delta_time);
+}
+
+void SystemScheduler::run(entt::registry& registry, float delta_time) {
+    if (m_dirty)
+        build(registry);
+
+    JobSystem& jobs = JobSystem::get();
+    for (const std::vector<size_t>& level : m_levels) {
+        // exclusive systems always end up alone in their level
+        if (level.size() == 1) {
+            execute(m_systems[level.front()], delta_time);
+            continue;
+        }
+
+        JobCounter counter;
+        for (size_t i = 1; i < level.size(); i++) {
+            SystemData* system = &m_systems[level[i]];
+            jobs.schedule([system, delta_time](){ execute(*system, delta_time); }, &counter);
+        }
+        // main thread takes the first one itself
+        execute(m_systems[level.front()], delta_time);
+        jobs.wait(counter);
+    }
+}
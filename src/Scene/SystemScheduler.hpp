@@ -0,0 +1,128 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "core/Metrics.hpp"
+
+// Systems declare which components they read and write. Two systems conflict
+// if one writes a component the other reads or writes. Conflicting systems
+// run in registration order, everything else may run concurrently on the
+// JobSystem.
+//
+//     scene.add_system("motion",
+//         System::Reads<Component::Motion>(), System::Writes<Component::Transform>(),
+//         [this](float dt){ ... }
+//     );
+//
+// Systems over a single view can derive their access from the view types,
+// const components are read and everything else is written:
+//
+//     scene.add_each_system<Component::Motion, const Component::Transform2D>("bounce",
+//         [](float dt, entt::entity e, Component::Motion& motion, const Component::Transform2D& transform){ ... }
+//     );
+//
+// Concurrent systems must not change the structure of the registry, i.e. no
+// creating/destroying entities or adding/removing components. Systems doing
+// that (or calling arbitrary callbacks) should be registered as exclusive.
+// Those run alone on the main thread.
+
+namespace System {
+    template <typename... Components> struct Reads {};
+    template <typename... Components> struct Writes {};
+
+    // Systems of a later phase always run after systems of an earlier phase
+    enum class Phase : uint8_t { Update, PostUpdate };
+}
+
+class SystemScheduler {
+private:
+    struct SystemData {
+        std::string name;
+        System::Phase phase;
+        bool exclusive;
+        std::vector<entt::id_type> reads;
+        std::vector<entt::id_type> writes;
+        std::function<void(float)> function;
+        // creates component storages ahead of time so concurrent views don't
+        std::function<void(entt::registry&)> prepare;
+        Metrics::Timer* timer;
+    };
+
+    std::vector<SystemData> m_systems;
+    // indices into m_systems, systems in one level don't conflict
+    std::vector<std::vector<size_t>> m_levels;
+    bool m_dirty = true;
+
+public:
+    template <typename... R, typename... W>
+    void add(
+            const std::string& name, System::Reads<R...>, System::Writes<W...>,
+            std::function<void(float)> function, System::Phase phase = System::Phase::Update
+        ) {
+        SystemData system;
+        system.name = name;
+        system.phase = phase;
+        system.exclusive = false;
+        system.reads = { entt::type_hash<R>::value()... };
+        system.writes = { entt::type_hash<W>::value()... };
+        system.function = std::move(function);
+        system.prepare = [](entt::registry& registry){
+            (registry.storage<R>(), ...);
+            (registry.storage<W>(), ...);
+        };
+        push(std::move(system));
+    }
+
+    template <typename... Components>
+    void add_view(const std::string& name, std::function<void(float)> function, System::Phase phase = System::Phase::Update) {
+        SystemData system;
+        system.name = name;
+        system.phase = phase;
+        system.exclusive = false;
+        (push_access<Components>(system), ...);
+        system.function = std::move(function);
+        system.prepare = [](entt::registry& registry){
+            (registry.storage<std::remove_const_t<Components>>(), ...);
+        };
+        push(std::move(system));
+    }
+
+    void add_exclusive(const std::string& name, std::function<void(float)> function, System::Phase phase = System::Phase::Update) {
+        SystemData system;
+        system.name = name;
+        system.phase = phase;
+        system.exclusive = true;
+        system.function = std::move(function);
+        push(std::move(system));
+    }
+
+    void remove(const std::string& name);
+    // Forces a rebuild, e.g. when the registry got replaced
+    void invalidate() { m_dirty = true; }
+
+    // Runs all systems, rebuilding the dependency graph if necessary
+    void run(entt::registry& registry, float delta_time);
+
+    const std::vector<std::vector<size_t>>& get_levels() const { return m_levels; }
+    const std::string& get_name(size_t index) const { return m_systems[index].name; }
+
+private:
+    template <typename Component>
+    static void push_access(SystemData& system) {
+        entt::id_type id = entt::type_hash<std::remove_const_t<Component>>::value();
+        if constexpr (std::is_const_v<Component>)
+            system.reads.push_back(id);
+        else
+            system.writes.push_back(id);
+    }
+
+    void push(SystemData&& system);
+    void build(entt::registry& registry);
+    static bool conflicts(const SystemData& a, const SystemData& b);
+    static void execute(SystemData& system, float delta_time);
+};
@@ -0,0 +1,96 @@
+#include "TransformBatch.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #define TRANSFORMBATCH_SSE
+    #include <xmmintrin.h>
+#endif
+
+static void compute_scalar(const Component::Transform& transform, InstanceMatrices& output) {
+    output.model = transform.get_matrix();
+    glm::mat3 normal = transform.get_normalmatrix();
+    output.normal[0] = glm::vec4(normal[0], 0.0f);
+    output.normal[1] = glm::vec4(normal[1], 0.0f);
+    output.normal[2] = glm::vec4(normal[2], 0.0f);
+}
+
+#ifdef TRANSFORMBATCH_SSE
+
+// Writes the 4 lanes of x, y, z, w as 4 vec4 columns, one per output
+static inline void store_columns(__m128 x, __m128 y, __m128 z, __m128 w, float* out0, float* out1, float* out2, float* out3) {
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_store_ps(out0, x);
+    _mm_store_ps(out1, y);
+    _mm_store_ps(out2, z);
+    _mm_store_ps(out3, w);
+}
+
+// Four transforms at a time, structure of arrays within registers
+static void compute_sse(const Component::Transform* t, InstanceMatrices* output) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 qx = _mm_setr_ps(t[0].rotation.x, t[1].rotation.x, t[2].rotation.x, t[3].rotation.x);
+    __m128 qy = _mm_setr_ps(t[0].rotation.y, t[1].rotation.y, t[2].rotation.y, t[3].rotation.y);
+    __m128 qz = _mm_setr_ps(t[0].rotation.z, t[1].rotation.z, t[2].rotation.z, t[3].rotation.z);
+    __m128 qw = _mm_setr_ps(t[0].rotation.w, t[1].rotation.w, t[2].rotation.w, t[3].rotation.w);
+
+    __m128 sx = _mm_setr_ps(t[0].scale.x, t[1].scale.x, t[2].scale.x, t[3].scale.x);
+    __m128 sy = _mm_setr_ps(t[0].scale.y, t[1].scale.y, t[2].scale.y, t[3].scale.y);
+    __m128 sz = _mm_setr_ps(t[0].scale.z, t[1].scale.z, t[2].scale.z, t[3].scale.z);
+
+    __m128 px = _mm_setr_ps(t[0].position.x, t[1].position.x, t[2].position.x, t[3].position.x);
+    __m128 py = _mm_setr_ps(t[0].position.y, t[1].position.y, t[2].position.y, t[3].position.y);
+    __m128 pz = _mm_setr_ps(t[0].position.z, t[1].position.z, t[2].position.z, t[3].position.z);
+
+    // rotation matrix, same as glm::toMat3 (r<column><row>)
+    __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+    __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+    __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+    __m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+    __m128 r01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+    __m128 r02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+    __m128 r10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+    __m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+    __m128 r12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+    __m128 r20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+    __m128 r21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+    __m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+    // normal matrix R * S^-1
+    __m128 isx = _mm_div_ps(one, sx), isy = _mm_div_ps(one, sy), isz = _mm_div_ps(one, sz);
+    __m128 n00 = _mm_mul_ps(r00, isx), n01 = _mm_mul_ps(r01, isx), n02 = _mm_mul_ps(r02, isx);
+    __m128 n10 = _mm_mul_ps(r10, isy), n11 = _mm_mul_ps(r11, isy), n12 = _mm_mul_ps(r12, isy);
+    __m128 n20 = _mm_mul_ps(r20, isz), n21 = _mm_mul_ps(r21, isz), n22 = _mm_mul_ps(r22, isz);
+
+    // model matrix R * S * T
+    r00 = _mm_mul_ps(r00, sx); r01 = _mm_mul_ps(r01, sx); r02 = _mm_mul_ps(r02, sx);
+    r10 = _mm_mul_ps(r10, sy); r11 = _mm_mul_ps(r11, sy); r12 = _mm_mul_ps(r12, sy);
+    r20 = _mm_mul_ps(r20, sz); r21 = _mm_mul_ps(r21, sz); r22 = _mm_mul_ps(r22, sz);
+
+    __m128 tx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r00, px), _mm_mul_ps(r10, py)), _mm_mul_ps(r20, pz));
+    __m128 ty = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r01, px), _mm_mul_ps(r11, py)), _mm_mul_ps(r21, pz));
+    __m128 tz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r02, px), _mm_mul_ps(r12, py)), _mm_mul_ps(r22, pz));
+
+    store_columns(r00, r01, r02, zero, &output[0].model[0][0], &output[1].model[0][0], &output[2].model[0][0], &output[3].model[0][0]);
+    store_columns(r10, r11, r12, zero, &output[0].model[1][0], &output[1].model[1][0], &output[2].model[1][0], &output[3].model[1][0]);
+    store_columns(r20, r21, r22, zero, &output[0].model[2][0], &output[1].model[2][0], &output[2].model[2][0], &output[3].model[2][0]);
+    store_columns(tx, ty, tz, one, &output[0].model[3][0], &output[1].model[3][0], &output[2].model[3][0], &output[3].model[3][0]);
+
+    store_columns(n00, n01, n02, zero, &output[0].normal[0][0], &output[1].normal[0][0], &output[2].normal[0][0], &output[3].normal[0][0]);
+    store_columns(n10, n11, n12, zero, &output[0].normal[1][0], &output[1].normal[1][0], &output[2].normal[1][0], &output[3].normal[1][0]);
+    store_columns(n20, n21, n22, zero, &output[0].normal[2][0], &output[1].normal[2][0], &output[2].normal[2][0], &output[3].normal[2][0]);
+}
+
+#endif
+
+void TransformBatch::compute(const Component::Transform* transforms, size_t count, InstanceMatrices* output) {
+    size_t i = 0;
+#ifdef TRANSFORMBATCH_SSE
+    for (; i + 4 <= count; i += 4)
+        compute_sse(transforms + i, output + i);
+#endif
+    for (; i < count; i++)
+        compute_scalar(transforms[i], output[i]);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "Components.hpp"
+#include "core/Metrics.hpp"
+
+// Computes model and normal matrices for many transforms at once, four at a
+// time with SSE where available. The output is one contiguous array which
+// can be uploaded as a per-instance buffer as is.
+
+// mat3 columns are padded to vec4 to match GPU layouts
+struct alignas(16) InstanceMatrices {
+    glm::mat4 model;
+    glm::vec4 normal[3];
+
+    glm::mat3 get_normalmatrix() const {
+        return glm::mat3(glm::vec3(normal[0]), glm::vec3(normal[1]), glm::vec3(normal[2]));
+    }
+};
+
+class TransformBatch {
+private:
+    std::vector<InstanceMatrices> m_instances;
+
+    Metrics::Timer& m_timer = Metrics::timer("TransformBatch/compute");
+    Metrics::Counter& m_computed = Metrics::counter("TransformBatch/matrices");
+
+public:
+    // Same as Transform::get_matrix() and get_normalmatrix() for `count`
+    // transforms
+    static void compute(const Component::Transform* transforms, size_t count, InstanceMatrices* output);
+
+    // Computes matrices for all entities in the owning group<Transform, ...>.
+    // Owned storages are packed in the same order, so the output is indexed
+    // by the position in the Transform storage (storage.index(entity)).
+    template <typename Group>
+    void update(entt::registry& registry, const Group& group) {
+        Metrics::Timer::Scope scope(m_timer);
+        auto& transforms = registry.storage<Component::Transform>();
+        const size_t count = group.size();
+        const size_t page_size = entt::component_traits<Component::Transform>::page_size;
+        const entt::entity* entities = transforms.data();
+
+        m_instances.resize(count);
+        // components are contiguous within a page
+        for (size_t first = 0; first < count; first += page_size) {
+            size_t n = std::min(page_size, count - first);
+            compute(&transforms.get(entities[first]), n, m_instances.data() + first);
+        }
+        m_computed.add(count);
+    }
+
+    InstanceMatrices& operator[](size_t idx) { return m_instances[idx]; }
+    const InstanceMatrices* data() const { return m_instances.data(); }
+    size_t size() const { return m_instances.size(); }
+};
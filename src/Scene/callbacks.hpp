@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <string_view>
+#include <unordered_map>
 
 #include <entt/entt.hpp>
 
@@ -15,7 +17,7 @@ namespace Callback {
     [[maybe_unused]] static const void log(Entity e) {
         std::cout << "[LOG] Entity " << (uint32_t) e.get_entity();
         if (e.has<Component::Name>())
-            std::cout << " " << e.get<Component::Name>();
+            std::cout << " " << e.get_name();
         std::cout << std::endl;
     }
 
@@ -24,11 +26,60 @@ namespace Callback {
     [[maybe_unused]] static const void do_nothing2(Entity e, Entity other) { return; }
     [[maybe_unused]] static const void destroy2(Entity e, Entity other) { e.schedule_delete(); }
     [[maybe_unused]] static const void log2(Entity e, Entity other) { log(e); }
+
+    // Components reference callbacks by the hashed name they are registered
+    // under. This keeps them trivially copyable, so they can be snapshotted
+    // and restored. Id 0 is "do nothing".
+    class Registry {
+    private:
+        std::unordered_map<entt::id_type, Function1> m_functions1;
+        std::unordered_map<entt::id_type, Function2> m_functions2;
+
+    public:
+        static entt::id_type id(std::string_view name) {
+            return entt::hashed_string::value(name.data(), name.size());
+        }
+
+        // The scenes callback registry lives in the registry context
+        static Registry& get(entt::registry& registry) {
+            return *registry.ctx().get<Registry*>();
+        }
+
+        entt::id_type add(std::string_view name, Function1 function) {
+            entt::id_type idx = id(name);
+            m_functions1[idx] = std::move(function);
+            return idx;
+        }
+
+        entt::id_type add(std::string_view name, Function2 function) {
+            entt::id_type idx = id(name);
+            m_functions2[idx] = std::move(function);
+            return idx;
+        }
+
+        void call(entt::id_type idx, Entity e) const {
+            if (idx == 0)
+                return;
+            auto it = m_functions1.find(idx);
+            if (it != m_functions1.end())
+                it->second(e);
+        }
+
+        void call(entt::id_type idx, Entity e, Entity other) const {
+            if (idx == 0)
+                return;
+            auto it = m_functions2.find(idx);
+            if (it != m_functions2.end())
+                it->second(e, other);
+        }
+    };
 }
 
 namespace Component {
+    // Per entity update callback for special cases. Updates shared by many
+    // entities should be systems instead, see AbstractScene::add_each_system.
     struct OnUpdate {
-        Callback::Function1 callback;
-        // void operator() (Entity& e) { callback(e); }
+        // id in Callback::Registry
+        entt::id_type callback = 0;
     };
 }
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -47,6 +51,28 @@ public:
         recalculate_view();
     }
 
+    // Visible area in world space as (left, right, bottom, top). With a
+    // rotation this is the bounding box of the visible area.
+    glm::vec4 get_lrbt() const {
+        if (m_rotation == 0.0f)
+            return glm::vec4(m_left, m_right, m_bottom, m_top) + 
+                glm::vec4(m_position.x, m_position.x, m_position.y, m_position.y);
+
+        float c = cos(glm::radians(m_rotation)), s = sin(glm::radians(m_rotation));
+        glm::vec4 output = glm::vec4(FLT_MAX, -FLT_MAX, FLT_MAX, -FLT_MAX);
+        for (float x : {m_left, m_right}) {
+            for (float y : {m_bottom, m_top}) {
+                float wx = m_position.x + c * x - s * y;
+                float wy = m_position.y + s * x + c * y;
+                output = glm::vec4(
+                    std::min(output.x, wx), std::max(output.y, wx), 
+                    std::min(output.z, wy), std::max(output.w, wy)
+                );
+            }
+        }
+        return output;
+    }
+
 // From parent
     void recalculate_view() override {
         // This includes an inverison
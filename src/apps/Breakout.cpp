@@ -8,7 +8,23 @@ Breakout::Breakout(Window* window)
     m_name = "Breakout";
     std::srand(glfwGetTime());
     m_scene.init();
-    m_physics.init(m_scene.get_registry());
+    m_physics.init(m_scene);
+    register_callbacks();
+
+    m_scene.add_snapshot_component<Component::Motion, 24>();
+    m_scene.add_snapshot_component<Component::Boundingbox2D, 20>();
+    m_scene.add_snapshot_component<Component::CollisionHandler, 4>();
+    m_scene.add_snapshot_component<Component::PlayBall, 1>();
+    m_scene.add_snapshot_component<Component::PowerUp, 1>();
+    m_scene.add_snapshot_component<Component::Brick, 1>();
+    m_scene.add_snapshot_component<Component::Paddle, 1>();
+
+    m_scene.add_system("Physics2D/motion", 
+        System::Reads<Component::Motion>(), System::Writes<Component::Transform2D>(), 
+        [this](float delta_time){ m_physics.resolve_motion(delta_time); }
+    );
+    // collision callbacks create and delete entities
+    m_scene.add_exclusive_system("Physics2D/collisions", [this](float){ m_physics.resolve_collisions(); });
     reset();
 }
 
@@ -16,10 +32,9 @@ void Breakout::update(float delta_time) {
     if (m_paused)
         return;
 
-    // Simulate physics world
-    m_physics.resolve_motion(delta_time);
-    m_physics.resolve_collisions();
+    // Simulate physics world & run other systems
     m_scene.update(delta_time);
+    m_ball_count = (int) m_scene.get_registry().storage<Component::PlayBall>().size();
 
     // Check gameover
     if (m_ball_count < 1) {
@@ -40,6 +55,10 @@ void Breakout::on_event(AbstractEvent& event) {
         KeyEvent& ke = static_cast<KeyEvent&>(event);
         if (ke.button == Key::R)
             reset();
+        else if (ke.button == Key::F5)
+            m_scene.save_snapshot("breakout.save");
+        else if ((ke.button == Key::F9) && m_scene.load_snapshot("breakout.save"))
+            on_restore();
         m_paused = false;
 
         if (ke.button == Key::Escape)
@@ -49,18 +68,44 @@ void Breakout::on_event(AbstractEvent& event) {
     }
 }
 
-void Breakout::create_ball(glm::vec2 pos, glm::vec2 vel) {
-    Entity ball = m_scene.create_circle("Ball", glm::vec3(pos, 0), 0.02f);
-    ball.add<Component::Boundingbox2D>(glm::vec2(0.0f), 1.0f, (Callback::Function2) Physics2D::resolve_reflection);
-    ball.add<Component::Motion>(vel);
-    ball.add<Component::OnUpdate>([this](Entity e){ 
-        auto pos = e.get<Component::Transform>().position;
-        if ((abs(pos.x) > 1.1) || (abs(pos.y) > 1.1)) {
-            e.schedule_delete();
-            this->m_ball_count--;
+void Breakout::register_callbacks() {
+    Callback::Registry& callbacks = m_scene.get_callbacks();
+
+    m_on_powerup_hit = callbacks.add("Breakout/powerup hit", [this](Entity powerup, Entity other){
+        if (other.has<Component::Paddle>()) {
+            powerup.schedule_delete();
+
+            auto& reg = this->m_scene.get_registry();
+            auto view = reg.view<Component::PlayBall>();
+
+            for (entt::entity e : view) {
+                auto motion = reg.get<Component::Motion>(e);
+                glm::vec3 v = motion.velocity;
+                glm::vec3 perp = glm::vec3(v.y, -v.x, v.z);
+                motion.velocity = glm::length(v) * glm::normalize(v - 0.2f * perp);
+                auto transform = reg.get<Component::Transform2D>(e);
+                create_ball(transform.position - 0.1f * glm::vec2(v), glm::length(v) * glm::normalize(v + 0.2f * perp));
+            }
         }
     });
-    m_ball_count++;
+
+    m_on_brick_hit = callbacks.add("Breakout/brick hit", [this](Entity brick, Entity other){
+        if (other.has<Component::PlayBall>()) {
+            brick.schedule_delete();
+            this->maybe_spawn_powerup();
+            this->screen_shake();
+        }
+    });
+}
+
+void Breakout::create_ball(glm::vec2 pos, glm::vec2 vel) {
+    // This gets called from collision callbacks, so the ball is only created
+    // when the scene flushes its commands
+    DeferredEntity ball = m_scene.create_deferred_circle("Ball", pos, 0.02f);
+    ball.add<Component::Boundingbox2D>(glm::vec2(0.0f), 1.0f);
+    ball.add<Component::CollisionHandler>(Physics2D::REFLECT);
+    ball.add<Component::Motion>(vel);
+    ball.add<Component::OutOfBounds>();
     ball.add<Component::PlayBall>();
 }
 
@@ -72,37 +117,38 @@ void Breakout::maybe_spawn_powerup() {
 
         std::cout << "Created powerup at " << x << std::endl;
 
-        Entity powerup = m_scene.create_circle("Powerup", glm::vec3(x, 0.5, 0), 0.02f, glm::vec4(0.1, 0.6, 0.2, 1.0));
-        powerup.add<Component::Boundingbox2D>(glm::vec2(0.0f), 1.0f, [this](Entity powerup, Entity other){
-            if (other.has<Component::Paddle>()) {
-                powerup.schedule_delete();
-
-                auto& reg = this->m_scene.get_registry();
-                auto view = reg.view<Component::PlayBall>();
-
-                for (entt::entity e : view) {
-                    auto motion = reg.get<Component::Motion>(e);
-                    glm::vec3 v = motion.velocity;
-                    glm::vec3 perp = glm::vec3(v.y, -v.x, v.z);
-                    motion.velocity = glm::length(v) * glm::normalize(v - 0.2f * perp);
-                    auto transform = reg.get<Component::Transform>(e);
-                    create_ball(transform.position - 0.1f * v, glm::length(v) * glm::normalize(v + 0.2f * perp));
-                }
-            }
-        });
-
+        // called from the brick hit callback, i.e. while Physics2D iterates
+        // the collision group
+        DeferredEntity powerup = m_scene.create_deferred_circle("Powerup", glm::vec2(x, 0.5), 0.02f, glm::vec4(0.1, 0.6, 0.2, 1.0));
+        powerup.add<Component::Boundingbox2D>(glm::vec2(0.0f), 1.0f);
+        powerup.add<Component::CollisionHandler>(m_on_powerup_hit);
         powerup.add<Component::Motion>(glm::vec2(0, -0.5));
         powerup.add<Component::PowerUp>();
-        powerup.add<Component::OnUpdate>([](Entity e){ 
-            auto pos = e.get<Component::Transform>().position;
-            if ((abs(pos.x) > 1.1f) || (abs(pos.y) > 1.1f)) 
-                e.schedule_delete();
-        });
+        powerup.add<Component::OutOfBounds>();
     }
 }
 
 void Breakout::reset() {
     m_score = 0;
+
+    // After the first build, restarting is just a snapshot restore
+    if (m_level.empty()) {
+        build_level();
+        m_scene.flush_commands();
+        m_level = m_scene.take_snapshot();
+    } else {
+        m_scene.restore_snapshot(m_level);
+    }
+
+    on_restore();
+}
+
+void Breakout::on_restore() {
+    m_paddle = m_scene.find_entity("Paddle");
+    m_ball_count = (int) m_scene.get_registry().view<Component::PlayBall>().size();
+}
+
+void Breakout::build_level() {
     m_scene.clear();
 
     // Add Ball
@@ -113,50 +159,55 @@ void Breakout::reset() {
     float aspect = 600.0f / 800.0f;
     glm::vec2 brick_scale = glm::vec2(0.19, 0.04);
 
-    Callback::Function2 on_brick_collision = [this](Entity brick, Entity other){
-        if (other.has<Component::PlayBall>()) {
-            brick.schedule_delete();
-            this->maybe_spawn_powerup();
-            this->screen_shake();
-        }
-    };
-
+    std::vector<glm::vec2> positions;
+    positions.reserve(columns * rows);
     for (int i = 0; i < columns; i++) {
         float x = (brick_scale.x + 0.01f) * i - 0.995f;
         for (int j = 0; j < rows; j++) {
             // aspect rescaling only works on init
             float y =  1.0f - (brick_scale.y + 0.01f / aspect) * (j + 1.0f); 
-            char name[16];
-            sprintf_s(name, 16, "Brick[%i, %i]", i, j);
-            Entity e = m_scene.create_quad(name, glm::vec3(x, y, 0.0f), brick_scale);
-            e.add<Component::Boundingbox2D>(Component::Boundingbox2D::Rect2D, on_brick_collision);
+            positions.push_back(glm::vec2(x, y));
         }
     }
 
+    auto& registry = m_scene.get_registry();
+    std::vector<entt::entity> bricks = m_scene.create_quads(positions, brick_scale, glm::vec4(0.4, 0.7, 0, 1), "Brick");
+    registry.insert<Component::Boundingbox2D>(bricks.begin(), bricks.end(), 
+        Component::Boundingbox2D(Component::Boundingbox2D::Rect2D)
+    );
+    registry.insert<Component::CollisionHandler>(bricks.begin(), bricks.end(), 
+        Component::CollisionHandler(m_on_brick_hit)
+    );
+    registry.insert<Component::Brick>(bricks.begin(), bricks.end());
+    registry.insert<Component::Static>(bricks.begin(), bricks.end());
+
     // Add paddle
-    m_paddle = m_scene.create_quad("Paddle", glm::vec3(0.0f, -0.96f, 0.0f), brick_scale);
-    m_paddle.add<Component::Boundingbox2D>(Component::Boundingbox2D::Rect2D);
-    m_paddle.add<Component::Paddle>();
+    Entity paddle = m_scene.create_quad("Paddle", glm::vec2(0.0f, -0.96f), brick_scale);
+    paddle.add<Component::Boundingbox2D>(Component::Boundingbox2D::Rect2D);
+    paddle.add<Component::Paddle>();
 
     // Add wall colliders
     Entity wall_l = m_scene.create_entity("Wall left");
     wall_l.add<Component::Boundingbox2D>(Component::Boundingbox2D::Rect2D);
-    wall_l.add<Component::Transform>(glm::vec3(-2.0f, -2.0f, 0.0f), glm::vec3(1.0f, 4.0f, 1.0f));
+    wall_l.add<Component::Transform2D>(glm::vec2(-2.0f, -2.0f), glm::vec2(1.0f, 4.0f));
     wall_l.add<Component::Quad>(glm::vec3(0, 0, 0));
+    wall_l.add<Component::Static>();
         
     Entity wall_r = m_scene.create_entity("Wall right");
     wall_r.add<Component::Boundingbox2D>(Component::Boundingbox2D::Rect2D);
-    wall_r.add<Component::Transform>(glm::vec3(1.0f, -2.0f, 0.0f), glm::vec3(1.0f, 4.0f, 1.0f));
+    wall_r.add<Component::Transform2D>(glm::vec2(1.0f, -2.0f), glm::vec2(1.0f, 4.0f));
     wall_r.add<Component::Quad>(glm::vec3(0, 0, 0));
+    wall_r.add<Component::Static>();
 
     Entity wall_top = m_scene.create_entity("Wall top");
     wall_top.add<Component::Boundingbox2D>(Component::Boundingbox2D::Rect2D);
-    wall_top.add<Component::Transform>(glm::vec3(-2.0f, 1.0f, 0.0f), glm::vec3(4.0f, 1.0f, 1.0f));
+    wall_top.add<Component::Transform2D>(glm::vec2(-2.0f, 1.0f), glm::vec2(4.0f, 1.0f));
     wall_top.add<Component::Quad>(glm::vec3(0, 0, 0));
+    wall_top.add<Component::Static>();
 }
 
 void Breakout::update_paddle_position() {
-    Component::Transform& transform = m_paddle.get<Component::Transform>();
+    Component::Transform2D& transform = m_paddle.get<Component::Transform2D>();
 
     float x = get_mouse_position().x;
     float w = (float) get_window_size().x;
@@ -27,6 +27,12 @@ private:
     uint16_t m_score = 0;
     bool m_paused = false;
 
+    // initial state of the level
+    std::vector<uint8_t> m_level;
+
+    entt::id_type m_on_powerup_hit = 0;
+    entt::id_type m_on_brick_hit = 0;
+
 public:
     Entity m_paddle;
     int m_ball_count = 0;
@@ -42,6 +48,11 @@ public:
     void reset();
 
 private:
+    void register_callbacks();
+    void build_level();
+    // fetches entities/state after the registry got replaced
+    void on_restore();
+
     void update_paddle_position(MouseMoveEvent& e) { return update_paddle_position(); }
     void update_paddle_position(WindowResizeEvent& e) { return update_paddle_position(); }
     void update_paddle_position();
@@ -25,6 +25,13 @@ public:
         cube.get<Component::Transform>().scale_by(glm::vec3(0.5f));
         cube.add<Component::SimpleTexture2D>("../assets/wood_container.jpg");
 
+        // Child cube, follows the sample cube
+        Entity child = m_scene.create_entity("Sample Child Cube");
+        MeshRenderer::add_cube_mesh(child);
+        child.add<Component::Transform>(glm::vec3(2.0f, 0.0f, 0.0f), glm::vec3(0.5f));
+        child.add<Component::SimpleTexture2D>("../assets/wood_container.jpg");
+        child.set_parent(cube);
+
         // Sample Voxel Chunk
         Entity chunk = m_scene.create_entity("Sample Chunk");
         chunk.add<Component::Chunk>(Component::Chunk::sample_data());
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <random>
+
+#include <glm/glm.hpp>
+
+#include "Scene/Scene2D.hpp"
+#include "physics/Physics.hpp"
+#include "core/Application.hpp"
+#include "core/Metrics.hpp"
+
+// Spawns a lot of moving quads to stress the ECS and 2D renderer
+// R respawns, Up/Down doubles/halves the number of entities, B compares view
+// and group iteration, T toggles textures (random tiles of one atlas)
+class StressTest2D : public SubApp {
+private:
+    Scene2D m_scene;
+    Physics2D m_physics;
+    size_t m_count = 100000;
+    Component::SpriteTexture m_atlas;
+    bool m_textured = false;
+
+    Metrics::Timer& m_spawn_time = Metrics::timer("StressTest2D/spawn");
+
+public:
+    StressTest2D(Window* window) : SubApp(window) {
+        m_name = "Stress Test 2D";
+        m_scene.init();
+        m_physics.init(m_scene);
+        m_atlas = m_scene.load_texture("../assets/texture_map.png");
+
+        m_scene.add_system("Physics2D/motion",
+            System::Reads<Component::Motion>(), System::Writes<Component::Transform2D>(),
+            [this](float delta_time){ m_physics.resolve_motion(delta_time); }
+        );
+        m_scene.add_system("StressTest2D/bounce",
+            System::Reads<Component::Transform2D>(), System::Writes<Component::Motion>(),
+            [this](float){ bounce(); }
+        );
+
+        spawn();
+    }
+
+    void update(float delta_time) override {
+        m_scene.update(delta_time);
+        m_scene.render(m_window->get_window_size());
+    }
+
+    void on_event(AbstractEvent& event) override {
+        if (event.type == EventType::KeyReleased) {
+            KeyEvent& ke = static_cast<KeyEvent&>(event);
+            if (ke.button == Key::B)
+                return benchmark();
+            if (ke.button == Key::Up)
+                m_count = 2 * m_count;
+            else if (ke.button == Key::Down)
+                m_count = std::max<size_t>(1, m_count / 2);
+            else if (ke.button == Key::T)
+                m_textured = !m_textured;
+            else if (ke.button != Key::R)
+                return;
+            spawn();
+        }
+    }
+
+    void spawn() {
+        m_scene.clear();
+
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        std::vector<glm::vec2> positions(m_count);
+        std::vector<Component::Motion> motions;
+        motions.reserve(m_count);
+        for (size_t i = 0; i < m_count; i++) {
+            positions[i] = glm::vec2(dist(rng), dist(rng));
+            motions.emplace_back(0.2f * glm::vec2(dist(rng), dist(rng)));
+        }
+
+        double start = glfwGetTime();
+        {
+            Metrics::Timer::Scope scope(m_spawn_time);
+            auto& registry = m_scene.get_registry();
+            std::vector<entt::entity> entities = m_scene.create_quads(positions, glm::vec2(0.005f));
+            registry.insert<Component::Motion>(entities.begin(), entities.end(), motions.begin());
+            if (m_textured)
+                apply_textures(entities, rng);
+        }
+        std::cout << "Spawned " << m_count << " entities in " << 1000.0 * (glfwGetTime() - start) << "ms" << std::endl;
+    }
+
+private:
+    // 16x16 tiles of 16x16 pixels
+    void apply_textures(const std::vector<entt::entity>& entities, std::mt19937& rng) {
+        std::uniform_int_distribution<int> tile(0, 15);
+        auto& quads = m_scene.get_registry().storage<Component::Quad>();
+        for (entt::entity e : entities) {
+            float x = tile(rng) / 16.0f, y = tile(rng) / 16.0f;
+            Component::Quad& quad = quads.get(e);
+            quad.color = glm::vec4(1.0f);
+            quad.texture = m_atlas.region(glm::vec4(x, y, x + 1.0f / 16.0f, y + 1.0f / 16.0f));
+        }
+    }
+
+    void bounce() {
+        auto group = m_scene.get_registry().group<Component::Motion>(entt::get<Component::Transform2D>);
+        for (auto [e, motion, transform] : group.each()) {
+            if (abs(transform.position.x) > 1.0f)
+                motion.velocity.x = -glm::sign(transform.position.x) * abs(motion.velocity.x);
+            if (abs(transform.position.y) > 1.0f)
+                motion.velocity.y = -glm::sign(transform.position.y) * abs(motion.velocity.y);
+        }
+    }
+
+    // Same loops as the render (dynamic sprites, i.e. without Static) and
+    // motion systems, once through multi-pool views and once through the
+    // groups Scene2D and Physics2D declare. Any other group owning Quad or
+    // Motion would conflict with those.
+    void benchmark() {
+        auto& registry = m_scene.get_registry();
+        const int repeats = 20;
+        glm::vec2 sum = glm::vec2(0.0f);
+
+        double start = glfwGetTime();
+        for (int i = 0; i < repeats; i++) {
+            auto quads = registry.view<Component::Transform2D, Component::Quad>(entt::exclude<Component::Static>);
+            for (auto [e, transform, quad] : quads.each())
+                sum += transform.position * quad.color.a;
+            auto motions = registry.view<Component::Transform2D, Component::Motion>();
+            for (auto [e, transform, motion] : motions.each())
+                sum += transform.position + glm::vec2(motion.velocity);
+        }
+        double view_time = (glfwGetTime() - start) / repeats;
+
+        start = glfwGetTime();
+        for (int i = 0; i < repeats; i++) {
+            auto quads = registry.group<Component::Quad>(entt::get<Component::Transform2D>, entt::exclude<Component::Static>);
+            for (auto [e, quad, transform] : quads.each())
+                sum += transform.position * quad.color.a;
+            auto motions = registry.group<Component::Motion>(entt::get<Component::Transform2D>);
+            for (auto [e, motion, transform] : motions.each())
+                sum += transform.position + glm::vec2(motion.velocity);
+        }
+        double group_time = (glfwGetTime() - start) / repeats;
+
+        std::cout << "Iterating " << registry.storage<Component::Quad>().size() << " entities: views " 
+            << 1000.0 * view_time << "ms, groups " << 1000.0 * group_time << "ms (" << sum.x << ")" << std::endl;
+    }
+};
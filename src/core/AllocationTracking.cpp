@@ -0,0 +1,66 @@
+// Opt-in replacement of the global operator new/delete which counts heap
+// allocations per frame and per Metrics::Timer scope. Enable it with
+//     cmake -D GLPLAYGROUND_TRACK_ALLOCATIONS=ON
+// Nothrow forms forward to these by default, the others are spelled out so
+// no library version sneaks in.
+
+#ifdef GLPLAYGROUND_TRACK_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+#include "Metrics.hpp"
+
+void* operator new(size_t size) {
+    Metrics::Allocations::record(size);
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr)
+        return;
+    Metrics::Allocations::record_free();
+    std::free(ptr);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    Metrics::Allocations::record(size);
+    size_t align = static_cast<size_t>(alignment);
+    size = size ? size : 1;
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(size, align);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, align < sizeof(void*) ? sizeof(void*) : align, size) != 0)
+        ptr = nullptr;
+#endif
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    if (!ptr)
+        return;
+    Metrics::Allocations::record_free();
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept { operator delete(ptr, alignment); }
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept { operator delete(ptr, alignment); }
+void operator delete[](void* ptr, size_t, std::align_val_t alignment) noexcept { operator delete(ptr, alignment); }
+
+#endif
@@ -1,8 +1,33 @@
 #include "Application.hpp"
+#include "Metrics.hpp"
+#include "JobSystem.hpp"
+#include "FrameArena.hpp"
+#include "RenderThread.hpp"
+#include "opengl/GLState.hpp"
+
+#include <cstdlib>
+
+// ImGui reuses its draw lists for the next frame, so the render thread gets
+// a copy
+struct ImGuiDrawSnapshot {
+    ImDrawData data;
+
+    ImGuiDrawSnapshot(const ImDrawData& source) : data(source) {
+        for (int i = 0; i < data.CmdListsCount; i++)
+            data.CmdLists[i] = source.CmdLists[i]->CloneOutput();
+    }
+    ~ImGuiDrawSnapshot() {
+        for (int i = 0; i < data.CmdListsCount; i++)
+            IM_DELETE(data.CmdLists[i]);
+    }
+    ImGuiDrawSnapshot(const ImGuiDrawSnapshot&) = delete;
+    ImGuiDrawSnapshot& operator=(const ImGuiDrawSnapshot&) = delete;
+};
 
 Application::Application() {};
 
 Application::~Application() {
+    JobSystem::get().shutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -14,6 +39,9 @@ Window* Application::get_window() const {
 }
 
 bool Application::init(const char* name, int width, int height) {
+    // worker threads, the calling thread becomes the main thread
+    JobSystem::get().init();
+
     m_window = new Window(name, width, height);
     if (m_window->init()) {
         m_window->connect_events(this);
@@ -37,6 +65,12 @@ bool Application::init(const char* name, int width, int height) {
         m_stats.push_back(OnlineStatistics());
         m_stats.push_back(OnlineStatistics());
 
+        // Let external tools scrape metrics from a running instance
+        if (const char* path = std::getenv("GLPLAYGROUND_METRICS_FILE"))
+            Metrics::Registry::get().export_to_file(path);
+        if (const char* port = std::getenv("GLPLAYGROUND_METRICS_PORT"))
+            Metrics::Registry::get().export_to_udp((uint16_t) std::atoi(port));
+
         return true;
     }
         
@@ -58,6 +92,16 @@ void Application::run() {
     float delta_time;
     char buffer[128];
 
+    // GL submission runs a frame behind on its own thread, unless disabled
+    RenderThread& render_thread = RenderThread::get();
+    static Metrics::Timer& render_time = Metrics::timer("RenderThread/frame");
+    static Metrics::Timer& render_latency = Metrics::timer("RenderThread/latency");
+    if (!std::getenv("GLPLAYGROUND_NO_RENDER_THREAD")) {
+        // creates the font atlas, ImGui::NewFrame() needs it on this thread
+        ImGui_ImplOpenGL3_NewFrame();
+        render_thread.start(m_window);
+    }
+
     m_running = true;
     while (m_running) {
         frame_time = glfwGetTime();
@@ -68,13 +112,19 @@ void Application::run() {
         // polling time stats
         m_stats[1].push(glfwGetTime() - temp_time);
 
+        // work deferred from jobs
+        JobSystem::get().flush_main_thread();
+
         delta_time = (float)(glfwGetTime() - last_time);
         last_time = glfwGetTime();
 
         // imgui
         {
             temp_time = glfwGetTime();
-            ImGui_ImplOpenGL3_NewFrame();
+            // With the render thread the backend's NewFrame runs there, right
+            // before drawing, it must not overlap ImGui::NewFrame() here
+            if (!render_thread.is_running())
+                ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
             ImGui::NewFrame();
             ImGui::Begin("Examples");
@@ -101,6 +151,25 @@ void Application::run() {
             ImGui::Text(buffer);
             sprintf_s(buffer, "ImGui: %0.3fms", 1000.0f * m_stats[3].mean());
             ImGui::Text(buffer);
+            if (render_thread.is_running()) {
+                // previous frame, the render thread is one behind
+                sprintf_s(buffer, "Render:  %0.3fms", render_time.last_frame_ms());
+                ImGui::Text(buffer);
+                sprintf_s(buffer, "Latency: %0.3fms", render_latency.last_frame_ms());
+                ImGui::Text(buffer);
+            }
+            if (Metrics::Allocations::enabled()) {
+                sprintf_s(buffer, "Allocs: %llu (%0.1f KB), frees: %llu", 
+                    (unsigned long long) Metrics::Allocations::last_frame_count(), 
+                    Metrics::Allocations::last_frame_bytes() / 1024.0, 
+                    (unsigned long long) Metrics::Allocations::last_frame_frees()
+                );
+                ImGui::Text(buffer);
+            }
+            ImGui::End();
+
+            ImGui::Begin("Metrics");
+            Metrics::Registry::get().draw_imgui_table();
             ImGui::End();
 
             imgui_delta_time = glfwGetTime() - temp_time;
@@ -114,11 +183,27 @@ void Application::run() {
         {
             temp_time = glfwGetTime();
             ImGui::Render();
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            if (render_thread.is_running()) {
+                auto snapshot = std::make_shared<ImGuiDrawSnapshot>(*ImGui::GetDrawData());
+                render_thread.run([snapshot](){
+                    // device objects exist since start(), this only touches
+                    // backend state owned by the render thread
+                    ImGui_ImplOpenGL3_NewFrame();
+                    ImGui_ImplOpenGL3_RenderDrawData(&snapshot->data);
+                    GLState::get().reset();
+                });
+            } else {
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+                // binds behind the back of the state cache
+                GLState::get().reset();
+            }
             m_stats[3].push(glfwGetTime() - temp_time + imgui_delta_time);
         }
 
-        m_window->swap_buffers();
+        render_thread.run([this](){ m_window->swap_buffers(); });
+        // waits for the last frame, i.e. main and render thread overlap by
+        // at most one frame
+        render_thread.submit_frame();
 
         if (m_window->should_close()) {
             m_running = false;
@@ -126,7 +211,13 @@ void Application::run() {
                 m_apps[j]->m_running = false;
         }
         m_stats[0].push(glfwGetTime() - frame_time);
+        // everything allocated from the arena this frame is gone now
+        FrameArena::get().reset();
+        Metrics::Registry::get().end_frame(glfwGetTime());
     }
+
+    // finishes the last frame, the context is ours again
+    render_thread.stop();
 };
 
 void Application::on_event(AbstractEvent& event) {
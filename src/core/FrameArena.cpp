@@ -0,0 +1,65 @@
+#include "FrameArena.hpp"
+
+#include <new>
+
+FrameArena& FrameArena::get() {
+    static FrameArena arena;
+    return arena;
+}
+
+FrameArena::FrameArena(size_t capacity) : m_capacity(capacity) {
+    m_block = static_cast<std::byte*>(::operator new(m_capacity, std::align_val_t(ALIGNMENT)));
+    m_capacity_gauge.set((double) m_capacity);
+}
+
+FrameArena::~FrameArena() {
+    reset();
+    ::operator delete(m_block, std::align_val_t(ALIGNMENT));
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    m_allocations.add();
+    m_bytes.add(bytes);
+    if (alignment > ALIGNMENT)
+        return allocate_overflow(bytes, alignment);
+
+    size_t offset = m_offset.load(std::memory_order_relaxed);
+    size_t start, end;
+    do {
+        start = (offset + alignment - 1) & ~(alignment - 1);
+        end = start + bytes;
+        if (end > m_capacity)
+            return allocate_overflow(bytes, alignment);
+    } while (!m_offset.compare_exchange_weak(offset, end, std::memory_order_relaxed));
+
+    return m_block + start;
+}
+
+void* FrameArena::allocate_overflow(size_t bytes, size_t alignment) {
+    m_overflows.add();
+    void* ptr = ::operator new(bytes, std::align_val_t(alignment));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_overflow.push_back({ptr, bytes, alignment});
+    m_overflow_bytes += bytes;
+    return ptr;
+}
+
+void FrameArena::reset() {
+    // grow so that this frames allocations would have fit
+    size_t needed = m_offset.load(std::memory_order_relaxed) + m_overflow_bytes;
+    if (needed > m_capacity) {
+        size_t capacity = m_capacity;
+        while (capacity < needed)
+            capacity *= 2;
+        ::operator delete(m_block, std::align_val_t(ALIGNMENT));
+        m_block = static_cast<std::byte*>(::operator new(capacity, std::align_val_t(ALIGNMENT)));
+        m_capacity = capacity;
+        m_capacity_gauge.set((double) m_capacity);
+    }
+
+    for (const Overflow& overflow : m_overflow)
+        ::operator delete(overflow.ptr, std::align_val_t(overflow.alignment));
+    m_overflow.clear();
+    m_overflow_bytes = 0;
+    m_offset.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "Metrics.hpp"
+
+// Linear allocator for memory that only lives for one frame. Allocating is a
+// pointer bump, deallocating does nothing and everything gets released at
+// once by reset() at the end of the frame (see Application::run). Allocating
+// is thread safe, resetting is not.
+//
+// Containers use it through std::pmr:
+//
+//     FrameVector<entt::entity> entities(FrameArena::get().allocator());
+//
+// When the block runs out allocations fall back to the heap. Those are
+// counted as "FrameArena/overflow" and the block grows to fit on the next
+// reset.
+
+class FrameArena : public std::pmr::memory_resource {
+private:
+    static const size_t ALIGNMENT = 64;
+
+    std::byte* m_block = nullptr;
+    size_t m_capacity = 0;
+    std::atomic<size_t> m_offset{0};
+
+    std::mutex m_mutex;
+    struct Overflow { void* ptr; size_t bytes; size_t alignment; };
+    std::vector<Overflow> m_overflow;
+    size_t m_overflow_bytes = 0;
+
+    Metrics::Counter& m_allocations = Metrics::counter("FrameArena/allocations");
+    Metrics::Counter& m_bytes = Metrics::counter("FrameArena/bytes");
+    Metrics::Counter& m_overflows = Metrics::counter("FrameArena/overflow");
+    Metrics::Gauge& m_capacity_gauge = Metrics::gauge("FrameArena/capacity");
+
+public:
+    explicit FrameArena(size_t capacity = 1 << 20);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    static FrameArena& get();
+
+    // Invalidates everything allocated since the last reset
+    void reset();
+
+    std::pmr::polymorphic_allocator<std::byte> allocator() { return this; }
+
+    size_t used() const { return m_offset.load(std::memory_order_relaxed); }
+    size_t capacity() const { return m_capacity; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    void* allocate_overflow(size_t bytes, size_t alignment);
+};
+
+template <typename T>
+using FrameVector = std::pmr::vector<T>;
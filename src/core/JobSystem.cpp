@@ -0,0 +1,284 @@
+#include "JobSystem.hpp"
+
+#include <iostream>
+
+// index into m_deques for worker threads and the main thread
+static thread_local size_t t_worker_index = SIZE_MAX;
+
+// WorkStealingDeque
+
+bool JobSystem::WorkStealingDeque::push(Job* job) {
+    int64_t b = m_bottom.load(std::memory_order_relaxed);
+    int64_t t = m_top.load(std::memory_order_acquire);
+    if (b - t >= CAPACITY)
+        return false;
+    m_buffer[b & MASK].store(job, std::memory_order_relaxed);
+    m_bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::pop() {
+    int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = m_top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // empty
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = m_buffer[b & MASK].load(std::memory_order_relaxed);
+    if (t == b) {
+        // last element, race against thieves
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::steal() {
+    int64_t t = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = m_bottom.load(std::memory_order_acquire);
+
+    if (t >= b)
+        return nullptr;
+
+    Job* job = m_buffer[t & MASK].load(std::memory_order_relaxed);
+    if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+bool JobSystem::WorkStealingDeque::empty() const {
+    return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+}
+
+// JobSystem
+
+JobSystem& JobSystem::get() {
+    static JobSystem system;
+    return system;
+}
+
+JobSystem::~JobSystem() {
+    shutdown();
+}
+
+void JobSystem::init(size_t workers) {
+    if (m_running)
+        return;
+
+    if (workers == SIZE_MAX) {
+        size_t hardware = std::thread::hardware_concurrency();
+        workers = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    m_main_thread = std::this_thread::get_id();
+    t_worker_index = 0;
+    m_running = true;
+
+    for (size_t i = 0; i <= workers; i++)
+        m_deques.push_back(std::make_unique<WorkStealingDeque>());
+    for (size_t i = 1; i <= workers; i++)
+        m_threads.emplace_back(&JobSystem::worker_loop, this, i);
+}
+
+size_t JobSystem::thread_index() {
+    return t_worker_index;
+}
+
+void JobSystem::shutdown() {
+    if (!m_running)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_running = false;
+    }
+    m_wake_up.notify_all();
+    for (std::thread& thread : m_threads)
+        thread.join();
+    m_threads.clear();
+
+    // Anything left over still gets executed so counters stay consistent
+    t_worker_index = 0;
+    while (Job* job = find_job(0))
+        execute(job);
+    m_deques.clear();
+    t_worker_index = SIZE_MAX;
+}
+
+void JobSystem::schedule(std::function<void()> function, JobCounter* counter) {
+    if (counter)
+        counter->m_count.fetch_add(1, std::memory_order_relaxed);
+
+    Job* job = new Job{std::move(function), counter};
+
+    if (!m_running) {
+        // not initialized (or shut down), run synchronously
+        execute(job);
+        return;
+    }
+    push(job);
+}
+
+void JobSystem::schedule_after(JobCounter& dependency, std::function<void()> function, JobCounter* counter) {
+    if (counter)
+        counter->m_count.fetch_add(1, std::memory_order_relaxed);
+
+    auto continuation = [this, f = std::move(function), counter]() mutable {
+        // counter was already incremented above
+        Job* job = new Job{std::move(f), counter};
+        if (m_running)
+            push(job);
+        else
+            execute(job);
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_mutex);
+        if (dependency.m_count.load(std::memory_order_acquire) > 0) {
+            dependency.m_continuations.push_back(std::move(continuation));
+            return;
+        }
+    }
+    continuation();
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    size_t index = t_worker_index;
+    while (!counter.done()) {
+        Job* job = (index < m_deques.size()) ? find_job(index) : nullptr;
+        if (job)
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+    // The last job decrements the counter while holding this lock. Taking it
+    // once makes sure it is done with the counter before we return.
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void JobSystem::run_on_main_thread(std::function<void()> function) {
+    if (is_main_thread()) {
+        function();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_main_mutex);
+    m_main_queue.push_back(std::move(function));
+}
+
+void JobSystem::flush_main_thread() {
+    {
+        std::lock_guard<std::mutex> lock(m_main_mutex);
+        std::swap(m_main_queue, m_main_queue_back);
+    }
+    for (auto& function : m_main_queue_back)
+        function();
+    m_main_queue_back.clear();
+}
+
+// Internals
+
+void JobSystem::push(Job* job) {
+    size_t index = t_worker_index;
+    if (index < m_deques.size()) {
+        if (!m_deques[index]->push(job)) {
+            // deque is full, just do it now
+            execute(job);
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(m_injection_mutex);
+        m_injected.push_back(job);
+        m_injected_count.fetch_add(1, std::memory_order_release);
+    }
+
+    // Pairs with the fence in worker_loop(). Either we see the sleeper or it
+    // sees the job, otherwise the wakeup would be lost.
+    m_pending.fetch_add(1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed) > 0) {
+        { std::lock_guard<std::mutex> lock(m_sleep_mutex); }
+        m_wake_up.notify_one();
+    }
+}
+
+JobSystem::Job* JobSystem::find_job(size_t index) {
+    Job* job = m_deques[index]->pop();
+
+    if (!job && m_injected_count.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(m_injection_mutex);
+        if (!m_injected.empty()) {
+            job = m_injected.back();
+            m_injected.pop_back();
+            m_injected_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (!job) {
+        size_t N = m_deques.size();
+        for (size_t i = 1; i < N && !job; i++) {
+            job = m_deques[(index + i) % N]->steal();
+            if (job)
+                m_jobs_stolen.add();
+        }
+    }
+
+    if (job)
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+}
+
+void JobSystem::execute(Job* job) {
+    job->function();
+    JobCounter* counter = job->counter;
+    delete job;
+    m_jobs_run.add();
+    if (counter)
+        finish(counter);
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    std::vector<std::function<void()>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        if (counter->m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            std::swap(continuations, counter->m_continuations);
+    }
+    // counter may be gone at this point
+    for (auto& continuation : continuations)
+        continuation();
+}
+
+void JobSystem::worker_loop(size_t index) {
+    t_worker_index = index;
+    int idle = 0;
+
+    while (m_running.load(std::memory_order_acquire)) {
+        Job* job = find_job(index);
+        if (job) {
+            execute(job);
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_sleeping.fetch_add(1, std::memory_order_acq_rel);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_wake_up.wait(lock, [this](){
+            return m_pending.load(std::memory_order_acquire) > 0 || !m_running.load(std::memory_order_acquire);
+        });
+        m_sleeping.fetch_sub(1, std::memory_order_acq_rel);
+        idle = 0;
+    }
+}
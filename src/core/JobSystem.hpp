@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Metrics.hpp"
+
+// A small job system. Each worker owns a work-stealing deque: it pushes and
+// pops jobs at the bottom while idle workers steal from the top. The thread
+// calling init() becomes worker 0 (the main thread) and helps out whenever it
+// waits on a JobCounter.
+//
+// Jobs can defer work to the main thread through run_on_main_thread(), which
+// get executed by flush_main_thread() once per frame. GL calls belong on the
+// render thread instead (see RenderThread::run()).
+
+class JobSystem;
+
+// Counts unfinished jobs. Jobs scheduled with schedule_after() start once the
+// counter drops to zero.
+class JobCounter {
+private:
+    std::atomic<int32_t> m_count{0};
+    std::mutex m_mutex;
+    std::vector<std::function<void()>> m_continuations;
+
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool done() const { return m_count.load(std::memory_order_acquire) == 0; }
+    int32_t count() const { return m_count.load(std::memory_order_acquire); }
+
+    friend class JobSystem;
+};
+
+class JobSystem {
+private:
+    struct Job {
+        std::function<void()> function;
+        JobCounter* counter = nullptr;
+    };
+
+    // Chase-Lev deque with fixed capacity (Le et al. 2013, "Correct and
+    // Efficient Work-Stealing for Weak Memory Models"). push/pop are owner
+    // only, steal may be called from any thread.
+    class WorkStealingDeque {
+    private:
+        static const int64_t CAPACITY = 4096;
+        static const int64_t MASK = CAPACITY - 1;
+
+        alignas(64) std::atomic<int64_t> m_top{0};
+        alignas(64) std::atomic<int64_t> m_bottom{0};
+        std::unique_ptr<std::atomic<Job*>[]> m_buffer;
+
+    public:
+        WorkStealingDeque() : m_buffer(new std::atomic<Job*>[CAPACITY]) {}
+
+        bool push(Job* job);
+        Job* pop();
+        Job* steal();
+        bool empty() const;
+    };
+
+    std::vector<std::thread> m_threads;
+    // one per worker + main thread at index 0
+    std::vector<std::unique_ptr<WorkStealingDeque>> m_deques;
+    std::atomic<bool> m_running{false};
+
+    // Jobs scheduled from threads which are not workers
+    std::mutex m_injection_mutex;
+    std::vector<Job*> m_injected;
+    std::atomic<uint32_t> m_injected_count{0};
+
+    // sleeping
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake_up;
+    std::atomic<int32_t> m_pending{0};
+    std::atomic<int32_t> m_sleeping{0};
+
+    // main thread queue
+    std::mutex m_main_mutex;
+    std::vector<std::function<void()>> m_main_queue;
+    std::vector<std::function<void()>> m_main_queue_back;
+    std::thread::id m_main_thread;
+
+    Metrics::Counter& m_jobs_run = Metrics::counter("JobSystem/jobs");
+    Metrics::Counter& m_jobs_stolen = Metrics::counter("JobSystem/steals");
+
+    JobSystem() = default;
+
+public:
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    static JobSystem& get();
+
+    // Starts `workers` threads next to the calling (main) thread.
+    // Defaults to one less than the number of hardware threads.
+    void init(size_t workers = SIZE_MAX);
+    void shutdown();
+
+    // number of threads executing jobs, including the main thread
+    size_t thread_count() const { return m_deques.empty() ? 1 : m_deques.size(); }
+    bool is_main_thread() const { return std::this_thread::get_id() == m_main_thread; }
+    // 0 on the main thread, 1.. on workers, SIZE_MAX on any other thread.
+    // Useful for per thread buffers of size thread_count().
+    static size_t thread_index();
+
+    // Queues `job`. If a counter is given it is incremented now and
+    // decremented once the job has finished.
+    void schedule(std::function<void()> job, JobCounter* counter = nullptr);
+    // Queues `job` once `dependency` reaches zero
+    void schedule_after(JobCounter& dependency, std::function<void()> job, JobCounter* counter = nullptr);
+    // Executes jobs on this thread until `counter` reaches zero
+    void wait(JobCounter& counter);
+
+    // Calls fn(first, last) for chunks of [begin, end) in parallel and
+    // returns once all chunks are done.
+    template <typename F>
+    void parallel_for(size_t begin, size_t end, size_t grain, F&& fn) {
+        if (end <= begin)
+            return;
+        grain = grain == 0 ? 1 : grain;
+        if (thread_count() == 1 || end - begin <= grain) {
+            fn(begin, end);
+            return;
+        }
+
+        JobCounter counter;
+        for (size_t first = begin; first < end; first += grain) {
+            size_t last = std::min(end, first + grain);
+            schedule([&fn, first, last](){ fn(first, last); }, &counter);
+        }
+        wait(counter);
+    }
+
+    // Calls fn(entity) for every entity in an entt view, in parallel chunks
+    // of the view's leading storage. fn must not add or remove components.
+    template <typename View, typename F>
+    void parallel_for_each(const View& view, F&& fn, size_t grain = 1024) {
+        const auto& storage = leading_storage(view.handle());
+        const auto* entities = storage.data();
+        parallel_for(0, storage.size(), grain, [&view, &fn, entities](size_t first, size_t last){
+            for (size_t i = first; i < last; i++)
+                if (view.contains(entities[i]))
+                    fn(entities[i]);
+        });
+    }
+
+    // Defer a function (e.g. GL calls) to the main thread
+    void run_on_main_thread(std::function<void()> function);
+    // Runs everything queued by run_on_main_thread(). Call on the main thread.
+    void flush_main_thread();
+
+private:
+    // entt returns the leading storage by pointer or reference depending on version
+    template <typename T> static const T& leading_storage(const T* storage) { return *storage; }
+    template <typename T> static const T& leading_storage(const T& storage) { return storage; }
+
+    void worker_loop(size_t index);
+    Job* find_job(size_t index);
+    void execute(Job* job);
+    void finish(JobCounter* counter);
+    void push(Job* job);
+};
@@ -0,0 +1,259 @@
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+#endif
+
+#include "Metrics.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <imgui.h>
+
+namespace Metrics {
+
+// Names are free form, quotes and backslashes need escaping in json
+static void write_json_string(std::ostream& stream, const std::string& string) {
+    stream << '"';
+    for (char c : string) {
+        if ((c == '"') || (c == '\\'))
+            stream << '\\';
+        stream << c;
+    }
+    stream << '"';
+}
+
+Registry& Registry::get() {
+    static Registry registry;
+    return registry;
+}
+
+Registry::~Registry() {
+    stop_export();
+}
+
+size_t Registry::find_or_add(const std::string& name, Type type) {
+    // caller holds m_mutex
+    auto it = m_name_to_entry.find(name);
+    if (it != m_name_to_entry.end()) {
+        const Entry& entry = m_entries[it->second];
+        if (entry.type != type)
+            throw std::invalid_argument("Metric " + name + " already exists with a different type.");
+        return entry.index;
+    }
+
+    size_t index;
+    switch (type) {
+    case Type::Counter: index = m_counters.size(); m_counters.emplace_back(); break;
+    case Type::Gauge:   index = m_gauges.size();   m_gauges.emplace_back();   break;
+    case Type::Timer:   index = m_timers.size();   m_timers.emplace_back();   break;
+    }
+    m_name_to_entry[name] = m_entries.size();
+    m_entries.push_back({name, type, index});
+    return index;
+}
+
+Counter& Registry::counter(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_counters[find_or_add(name, Type::Counter)];
+}
+
+Gauge& Registry::gauge(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_gauges[find_or_add(name, Type::Gauge)];
+}
+
+Timer& Registry::timer(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timers[find_or_add(name, Type::Timer)];
+}
+
+void Registry::end_frame(double time) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Counter& counter : m_counters)
+            counter.end_frame();
+        for (Timer& timer : m_timers)
+            timer.end_frame();
+        Allocations::end_frame();
+        m_frame++;
+    }
+
+    if ((!m_export_path.empty() || m_socket >= 0) && (time - m_last_export >= m_export_interval)) {
+        m_last_export = time;
+        export_snapshot();
+    }
+}
+
+void Registry::write_json(std::ostream& stream) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stream << "{\"frame\": " << m_frame;
+    if (Allocations::enabled())
+        stream << ", \"allocations\": {\"count\": " << Allocations::last_frame_count() 
+            << ", \"bytes\": " << Allocations::last_frame_bytes() 
+            << ", \"frees\": " << Allocations::last_frame_frees() << "}";
+    stream << ", \"metrics\": {";
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        const Entry& entry = m_entries[i];
+        if (i > 0)
+            stream << ", ";
+        write_json_string(stream, entry.name);
+        stream << ": ";
+        switch (entry.type) {
+        case Type::Counter: {
+            const Counter& c = m_counters[entry.index];
+            stream << "{\"frame\": " << c.last_frame() << ", \"total\": " << c.total() << "}";
+            break;
+        }
+        case Type::Gauge:
+            stream << m_gauges[entry.index].value();
+            break;
+        case Type::Timer: {
+            const Timer& t = m_timers[entry.index];
+            stream << "{\"ms\": " << t.last_frame_ms() << ", \"count\": " << t.last_frame_count();
+            if (Allocations::enabled())
+                stream << ", \"allocations\": " << t.last_frame_allocations() << ", \"allocated bytes\": " << t.last_frame_allocated_bytes();
+            stream << "}";
+            break;
+        }
+        }
+    }
+    stream << "}}";
+}
+
+void Registry::draw_imgui_table() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable;
+    if (!ImGui::BeginTable("Metrics", 3, flags))
+        return;
+
+    ImGui::TableSetupColumn("Name");
+    ImGui::TableSetupColumn("Frame");
+    ImGui::TableSetupColumn("Total");
+    ImGui::TableHeadersRow();
+
+    for (const Entry& entry : m_entries) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(entry.name.c_str());
+
+        switch (entry.type) {
+        case Type::Counter: {
+            const Counter& c = m_counters[entry.index];
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long) c.last_frame());
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long) c.total());
+            break;
+        }
+        case Type::Gauge:
+            ImGui::TableNextColumn();
+            ImGui::Text("%g", m_gauges[entry.index].value());
+            ImGui::TableNextColumn();
+            break;
+        case Type::Timer: {
+            const Timer& t = m_timers[entry.index];
+            ImGui::TableNextColumn();
+            ImGui::Text("%0.3fms", t.last_frame_ms());
+            ImGui::TableNextColumn();
+            if (Allocations::enabled())
+                ImGui::Text("%llu calls, %llu allocs", (unsigned long long) t.last_frame_count(), (unsigned long long) t.last_frame_allocations());
+            else
+                ImGui::Text("%llu calls", (unsigned long long) t.last_frame_count());
+            break;
+        }
+        }
+    }
+
+    ImGui::EndTable();
+}
+
+// Exporting
+
+void Registry::export_to_file(const std::string& filepath, double interval) {
+    m_export_path = filepath;
+    m_export_interval = interval;
+}
+
+bool Registry::export_to_udp(uint16_t port, double interval) {
+    if (m_socket >= 0)
+        return true;
+
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+        std::cout << "Failed to initialize winsock." << std::endl;
+        return false;
+    }
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        std::cout << "Failed to create metrics socket." << std::endl;
+        WSACleanup();
+        return false;
+    }
+    m_socket = (int64_t) s;
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0) {
+        std::cout << "Failed to create metrics socket." << std::endl;
+        return false;
+    }
+    m_socket = s;
+#endif
+
+    m_port = port;
+    m_export_interval = interval;
+    return true;
+}
+
+void Registry::stop_export() {
+    m_export_path.clear();
+    if (m_socket >= 0) {
+#ifdef _WIN32
+        closesocket((SOCKET) m_socket);
+        WSACleanup();
+#else
+        close((int) m_socket);
+#endif
+        m_socket = -1;
+    }
+}
+
+void Registry::export_snapshot() {
+    std::stringstream stream;
+    write_json(stream);
+    std::string snapshot = stream.str();
+
+    if (!m_export_path.empty()) {
+        std::ofstream file(m_export_path, std::ios::trunc);
+        if (file.is_open())
+            file << snapshot << std::endl;
+    }
+
+    if (m_socket >= 0) {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(m_port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+#ifdef _WIN32
+        sendto((SOCKET) m_socket, snapshot.data(), (int) snapshot.size(), 0, (sockaddr*) &address, sizeof(address));
+#else
+        sendto((int) m_socket, snapshot.data(), snapshot.size(), 0, (sockaddr*) &address, sizeof(address));
+#endif
+    }
+}
+
+}
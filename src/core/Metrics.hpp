@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Named counters, gauges and timers that any subsystem can update.
+// Looking a metric up by name takes a lock, so call sites should keep the
+// returned reference around (e.g. in a static local). Updating it afterwards
+// is just an atomic operation and safe from any thread.
+//
+//     static Metrics::Counter& draw_calls = Metrics::counter("Renderer2D/draw calls");
+//     draw_calls.add();
+
+namespace Metrics {
+
+    // Accumulates over a frame, e.g. draw calls or uploaded bytes
+    class Counter {
+    private:
+        std::atomic<uint64_t> m_current{0};
+        std::atomic<uint64_t> m_last_frame{0};
+        std::atomic<uint64_t> m_total{0};
+
+    public:
+        void add(uint64_t n = 1) { m_current.fetch_add(n, std::memory_order_relaxed); }
+
+        uint64_t last_frame() const { return m_last_frame.load(std::memory_order_relaxed); }
+        uint64_t total() const { return m_total.load(std::memory_order_relaxed); }
+
+        void end_frame() {
+            uint64_t value = m_current.exchange(0, std::memory_order_relaxed);
+            m_last_frame.store(value, std::memory_order_relaxed);
+            m_total.fetch_add(value, std::memory_order_relaxed);
+        }
+    };
+
+    // Holds the last value set, e.g. the number of entities alive. There is
+    // one per name, whoever sets it last wins.
+    class Gauge {
+    private:
+        std::atomic<double> m_value{0.0};
+
+    public:
+        void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+        double value() const { return m_value.load(std::memory_order_relaxed); }
+    };
+
+    // Accumulates durations over a frame. With allocation tracking enabled
+    // (see Allocations) it also counts heap allocations made inside its
+    // scopes, including nested ones, on the thread that opened the scope.
+    class Timer {
+    private:
+        std::atomic<uint64_t> m_current_ns{0};
+        std::atomic<uint64_t> m_current_count{0};
+        std::atomic<uint64_t> m_last_ns{0};
+        std::atomic<uint64_t> m_last_count{0};
+
+        std::atomic<uint64_t> m_current_allocs{0};
+        std::atomic<uint64_t> m_current_alloc_bytes{0};
+        std::atomic<uint64_t> m_last_allocs{0};
+        std::atomic<uint64_t> m_last_alloc_bytes{0};
+
+    public:
+        void record(std::chrono::nanoseconds duration) {
+            m_current_ns.fetch_add(duration.count(), std::memory_order_relaxed);
+            m_current_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        void record(double seconds) {
+            record(std::chrono::nanoseconds((int64_t) (1e9 * seconds)));
+        }
+        void record_allocation(size_t bytes) {
+            m_current_allocs.fetch_add(1, std::memory_order_relaxed);
+            m_current_alloc_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        // summed time of last frame
+        double last_frame_ms() const { return 1e-6 * m_last_ns.load(std::memory_order_relaxed); }
+        uint64_t last_frame_count() const { return m_last_count.load(std::memory_order_relaxed); }
+        uint64_t last_frame_allocations() const { return m_last_allocs.load(std::memory_order_relaxed); }
+        uint64_t last_frame_allocated_bytes() const { return m_last_alloc_bytes.load(std::memory_order_relaxed); }
+
+        void end_frame() {
+            m_last_ns.store(m_current_ns.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_last_count.store(m_current_count.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_last_allocs.store(m_current_allocs.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_last_alloc_bytes.store(m_current_alloc_bytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        // Records the lifetime of this object
+        struct Scope {
+            Timer& timer;
+            std::chrono::steady_clock::time_point start;
+            // enclosing scope on this thread
+            Scope* parent;
+
+            static inline thread_local Scope* current = nullptr;
+
+            Scope(Timer& t) : timer(t), start(std::chrono::steady_clock::now()), parent(current) { current = this; }
+            ~Scope() { 
+                current = parent;
+                timer.record(std::chrono::steady_clock::now() - start); 
+            }
+        };
+    };
+
+    // Heap allocations through the global operator new/delete. These are
+    // only counted when building with GLPLAYGROUND_TRACK_ALLOCATIONS, which
+    // replaces them (see AllocationTracking.cpp). Must not allocate itself.
+    class Allocations {
+    private:
+        static inline std::atomic<uint64_t> s_count{0};
+        static inline std::atomic<uint64_t> s_bytes{0};
+        static inline std::atomic<uint64_t> s_frees{0};
+        static inline std::atomic<uint64_t> s_last_count{0};
+        static inline std::atomic<uint64_t> s_last_bytes{0};
+        static inline std::atomic<uint64_t> s_last_frees{0};
+
+    public:
+        static constexpr bool enabled() {
+#ifdef GLPLAYGROUND_TRACK_ALLOCATIONS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        static void record(size_t bytes) {
+            s_count.fetch_add(1, std::memory_order_relaxed);
+            s_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            for (Timer::Scope* scope = Timer::Scope::current; scope; scope = scope->parent)
+                scope->timer.record_allocation(bytes);
+        }
+        static void record_free() {
+            s_frees.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static uint64_t last_frame_count() { return s_last_count.load(std::memory_order_relaxed); }
+        static uint64_t last_frame_bytes() { return s_last_bytes.load(std::memory_order_relaxed); }
+        static uint64_t last_frame_frees() { return s_last_frees.load(std::memory_order_relaxed); }
+
+        static void end_frame() {
+            s_last_count.store(s_count.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            s_last_bytes.store(s_bytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            s_last_frees.store(s_frees.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    };
+
+    class Registry {
+    private:
+        enum class Type : uint8_t { Counter, Gauge, Timer };
+
+        struct Entry {
+            std::string name;
+            Type type;
+            size_t index;
+        };
+
+        // deques so references handed out stay valid when we grow
+        std::deque<Counter> m_counters;
+        std::deque<Gauge> m_gauges;
+        std::deque<Timer> m_timers;
+
+        mutable std::mutex m_mutex;
+        std::vector<Entry> m_entries;
+        std::unordered_map<std::string, size_t> m_name_to_entry;
+
+        // periodic export
+        uint64_t m_frame = 0;
+        double m_export_interval = 1.0;
+        double m_last_export = 0.0;
+        std::string m_export_path;
+        int64_t m_socket = -1;
+        uint16_t m_port = 0;
+
+        Registry() = default;
+
+    public:
+        ~Registry();
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+
+        static Registry& get();
+
+        Counter& counter(const std::string& name);
+        Gauge& gauge(const std::string& name);
+        Timer& timer(const std::string& name);
+
+        // Latches per-frame values and runs periodic exports. Call once per
+        // frame from the main loop.
+        void end_frame(double time);
+
+        // Snapshot of all metrics as a single line of json
+        void write_json(std::ostream& stream) const;
+        void draw_imgui_table() const;
+
+        // Periodically (over-)write a snapshot to the given file
+        void export_to_file(const std::string& filepath, double interval = 1.0);
+        // Periodically send a snapshot as a UDP datagram to localhost:port
+        bool export_to_udp(uint16_t port, double interval = 1.0);
+        void stop_export();
+
+    private:
+        size_t find_or_add(const std::string& name, Type type);
+        void export_snapshot();
+    };
+
+    inline Counter& counter(const std::string& name) { return Registry::get().counter(name); }
+    inline Gauge& gauge(const std::string& name) { return Registry::get().gauge(name); }
+    inline Timer& timer(const std::string& name) { return Registry::get().timer(name); }
+}
@@ -0,0 +1,98 @@
+#include "RenderThread.hpp"
+
+#include "opengl/Window.hpp"
+
+RenderThread& RenderThread::get() {
+    static RenderThread thread;
+    return thread;
+}
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+void RenderThread::start(Window* window) {
+    if (m_running)
+        return;
+
+    m_window = window;
+    m_running = true;
+    // a context can only be current on one thread
+    glfwMakeContextCurrent(nullptr);
+    m_thread = std::thread(&RenderThread::thread_loop, this);
+}
+
+void RenderThread::stop() {
+    if (!m_running)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+        m_recording.clear();
+    }
+    m_frame_ready.notify_one();
+    m_thread.join();
+    m_window->activate();
+}
+
+void RenderThread::run(std::function<void()> function) {
+    if (!m_running || is_render_thread()) {
+        function();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_recording.push_back(std::move(function));
+}
+
+void RenderThread::submit_frame() {
+    if (!m_running)
+        return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    {
+        Metrics::Timer::Scope scope(m_wait_timer);
+        m_frame_done.wait(lock, [this](){ return !m_has_frame; });
+    }
+    std::swap(m_recording, m_executing);
+    m_has_frame = true;
+    m_submit_time = std::chrono::steady_clock::now();
+    lock.unlock();
+    m_frame_ready.notify_one();
+}
+
+void RenderThread::wait() {
+    if (!m_running)
+        return;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_frame_done.wait(lock, [this](){ return !m_has_frame; });
+}
+
+void RenderThread::thread_loop() {
+    s_is_render_thread = true;
+    m_window->activate();
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_frame_ready.wait(lock, [this](){ return m_has_frame || !m_running; });
+        // the last frame still gets drawn
+        if (!m_has_frame)
+            break;
+        lock.unlock();
+
+        {
+            Metrics::Timer::Scope scope(m_frame_timer);
+            for (auto& function : m_executing)
+                function();
+            m_executing.clear();
+        }
+        m_latency.record(std::chrono::steady_clock::now() - m_submit_time);
+
+        lock.lock();
+        m_has_frame = false;
+        lock.unlock();
+        m_frame_done.notify_all();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Metrics.hpp"
+
+class Window;
+
+// Runs GL work one frame behind the main thread. While the main thread
+// simulates and records frame N, the render thread submits frame N-1 and
+// swaps buffers. A frame is the list of functions passed to run() between
+// two submit_frame() calls. submit_frame() waits for the previous frame to
+// finish, so there is at most one frame in flight.
+//
+// Once started the render thread owns the GL context. Anything the main
+// thread wants to do with GL has to go through run(), and whatever those
+// functions read must not change until the frame is done. Render queues
+// record into one half while the other executes (see RenderQueue::close()).
+// GL objects are created before start() or inside run(). Deleting them is
+// deferred through run() by the opengl wrappers.
+//
+// Before start() (or after stop()) run() calls the function right away on
+// the calling thread, which is then expected to own the context.
+class RenderThread {
+private:
+    Window* m_window = nullptr;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    static inline thread_local bool s_is_render_thread = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_frame_ready;
+    std::condition_variable m_frame_done;
+    // recorded by the main thread, swapped over in submit_frame()
+    std::vector<std::function<void()>> m_recording;
+    std::vector<std::function<void()>> m_executing;
+    bool m_has_frame = false;
+    std::chrono::steady_clock::time_point m_submit_time;
+
+    Metrics::Timer& m_frame_timer = Metrics::timer("RenderThread/frame");
+    Metrics::Timer& m_wait_timer = Metrics::timer("RenderThread/main thread waiting");
+    // submit_frame() to the end of the frame (i.e. the swap), the latency
+    // added over rendering on the main thread
+    Metrics::Timer& m_latency = Metrics::timer("RenderThread/latency");
+
+    RenderThread() = default;
+
+public:
+    ~RenderThread();
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    static RenderThread& get();
+
+    // Moves the GL context of `window` from the calling thread to a new
+    // render thread
+    void start(Window* window);
+    // Finishes the frame in flight and moves the context back to the
+    // calling thread. Anything recorded but not submitted is dropped.
+    void stop();
+
+    bool is_running() const { return m_running; }
+    static bool is_render_thread() { return s_is_render_thread; }
+
+    // Adds `function` to the frame being recorded, runs it right away
+    // without a render thread. Thread safe.
+    void run(std::function<void()> function);
+    // Hands the recorded frame to the render thread, after waiting for the
+    // previous one. Main thread only.
+    void submit_frame();
+    // Waits until the frame in flight is done
+    void wait();
+
+private:
+    void thread_loop();
+};
@@ -1,6 +1,7 @@
 #include "apps/Breakout.hpp"
 #include "apps/Example3D.hpp"
 #include "apps/VoxelExample.hpp"
+#include "apps/StressTest2D.hpp"
 
 int main() {
     Application main;
@@ -8,6 +9,7 @@ int main() {
     main.push_back<Example3D>();
     main.push_back<VoxelExample>();
     main.push_back<Breakout>();
+    main.push_back<StressTest2D>();
     main.run();
 
     return 0;
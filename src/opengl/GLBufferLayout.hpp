@@ -19,11 +19,17 @@ glVertexAttribPointer:
 */
 
 // Aliases for GL types so we can keep things seperated
+// Byte and Short types with normalize = true become floats in [0, 1] (or
+// [-1, 1] for signed types) in the shader, e.g. UByte4 for RGBA8 colors.
+// Half types are 16 bit floats, see GLPackedTypes.hpp.
 enum class GLType{
 	Bool,
+	UByte, UByte2, UByte3, UByte4,
+	Byte, Byte2, Byte3, Byte4,
 	UShort, UShort2, UShort3, UShort4,
 	Short, Short2, Short3, Short4,
 	Int, Int2, Int3, Int4,
+	Half, Half2, Half3, Half4,
 	Float, Float2, Float3, Float4,
 	Mat3, Mat4
 };
@@ -31,6 +37,14 @@ enum class GLType{
 static unsigned int gltype_byte_size(GLType type) {
     switch (type) {
 		case GLType::Bool: return 1;
+		case GLType::UByte:  return 1;
+		case GLType::UByte2: return 2;
+		case GLType::UByte3: return 3;
+		case GLType::UByte4: return 4;
+		case GLType::Byte:  return 1;
+		case GLType::Byte2: return 2;
+		case GLType::Byte3: return 3;
+		case GLType::Byte4: return 4;
 		case GLType::Short:  return 2;
 		case GLType::Short2: return 2 * 2;
 		case GLType::Short3: return 2 * 3;
@@ -43,6 +57,10 @@ static unsigned int gltype_byte_size(GLType type) {
 		case GLType::Int2: return 4 * 2;
 		case GLType::Int3: return 4 * 3;
 		case GLType::Int4: return 4 * 4;
+		case GLType::Half:  return 2;
+		case GLType::Half2: return 2 * 2;
+		case GLType::Half3: return 2 * 3;
+		case GLType::Half4: return 2 * 4;
 		case GLType::Float:  return 4;
 		case GLType::Float2: return 4 * 2;
 		case GLType::Float3: return 4 * 3;
@@ -57,6 +75,14 @@ static unsigned int gltype_byte_size(GLType type) {
 static unsigned int gltype_length(GLType type) {
 	switch (type) {
         case GLType::Bool: return 1;
+		case GLType::UByte:  return 1;
+		case GLType::UByte2: return 2;
+		case GLType::UByte3: return 3;
+		case GLType::UByte4: return 4;
+		case GLType::Byte:  return 1;
+		case GLType::Byte2: return 2;
+		case GLType::Byte3: return 3;
+		case GLType::Byte4: return 4;
 		case GLType::Short:  return 1;
 		case GLType::Short2: return 2;
 		case GLType::Short3: return 3;
@@ -69,6 +95,10 @@ static unsigned int gltype_length(GLType type) {
         case GLType::Int2: return 2;
         case GLType::Int3: return 3;
         case GLType::Int4: return 4;
+        case GLType::Half:  return 1;
+        case GLType::Half2: return 2;
+        case GLType::Half3: return 3;
+        case GLType::Half4: return 4;
         case GLType::Float:  return 1;
         case GLType::Float2: return 2;
         case GLType::Float3: return 3;
@@ -83,6 +113,14 @@ static unsigned int gltype_length(GLType type) {
 [[maybe_unused]] static GLenum gl_native_type(GLType type) {
 	switch (type) {
         case GLType::Bool: return GL_BOOL;
+		case GLType::UByte:  return GL_UNSIGNED_BYTE;
+		case GLType::UByte2: return GL_UNSIGNED_BYTE;
+		case GLType::UByte3: return GL_UNSIGNED_BYTE;
+		case GLType::UByte4: return GL_UNSIGNED_BYTE;
+		case GLType::Byte:  return GL_BYTE;
+		case GLType::Byte2: return GL_BYTE;
+		case GLType::Byte3: return GL_BYTE;
+		case GLType::Byte4: return GL_BYTE;
 		case GLType::Short:  return GL_SHORT;
 		case GLType::Short2: return GL_SHORT;
 		case GLType::Short3: return GL_SHORT;
@@ -95,6 +133,10 @@ static unsigned int gltype_length(GLType type) {
         case GLType::Int2: return GL_INT;
         case GLType::Int3: return GL_INT;
         case GLType::Int4: return GL_INT;
+        case GLType::Half:  return GL_HALF_FLOAT;
+        case GLType::Half2: return GL_HALF_FLOAT;
+        case GLType::Half3: return GL_HALF_FLOAT;
+        case GLType::Half4: return GL_HALF_FLOAT;
         case GLType::Float:  return GL_FLOAT;
         case GLType::Float2: return GL_FLOAT;
         case GLType::Float3: return GL_FLOAT;
@@ -106,6 +148,18 @@ static unsigned int gltype_length(GLType type) {
 	return 0;
 }
 
+[[maybe_unused]] static bool is_integer_type(GLType type) {
+	switch (gl_native_type(type)) {
+		case GL_BOOL:
+		case GL_UNSIGNED_BYTE: case GL_BYTE:
+		case GL_UNSIGNED_SHORT: case GL_SHORT:
+		case GL_UNSIGNED_INT: case GL_INT:
+			return true;
+		default:
+			return false;
+	}
+}
+
 // Information for one block of data in a vertex (* coming from one glBuffer object)
 struct GLBufferElement {
     std::string name;   // for usability, e.g. position, normal
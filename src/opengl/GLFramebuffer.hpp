@@ -6,6 +6,7 @@
 #include <exception>
 
 #include "GLTexture.hpp"
+#include "core/RenderThread.hpp"
 
 class GLFramebuffer {
 private:
@@ -39,7 +40,8 @@ public:
         m_textures.reserve(34);
     }
     ~GLFramebuffer() {
-        glDeleteFramebuffers(1, &m_id);
+        // a frame in flight may still use it
+        RenderThread::get().run([id = m_id](){ glDeleteFramebuffers(1, &id); });
     }
 
     void bind(GLenum mode = GL_FRAMEBUFFER) const {
@@ -133,7 +135,7 @@ public:
         glCreateRenderbuffers(1, &m_id);
     }
     ~GLRenderbuffer() {
-        glDeleteRenderbuffers(1, &m_id);
+        RenderThread::get().run([id = m_id](){ glDeleteRenderbuffers(1, &id); });
     }
 
     void bind() {
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+// Compact vertex attribute types. Use these with GLType::Half* and (with
+// normalize = true) GLType::UByte4 in a GLBufferLayout.
+
+// IEEE 754 half precision float (10 bit mantissa, about 3 decimal digits)
+struct Half {
+    uint16_t bits = 0;
+
+    Half() = default;
+    Half(float value) : bits(from_float(value)) {}
+
+    operator float() const { return to_float(bits); }
+
+    // rounds to nearest even
+    static uint16_t from_float(float value) {
+        uint32_t x;
+        std::memcpy(&x, &value, sizeof(float));
+        uint32_t sign = (x >> 16) & 0x8000;
+        uint32_t mantissa = x & 0x7fffff;
+        int32_t exponent = (int32_t) ((x >> 23) & 0xff);
+
+        if (exponent == 0xff) // inf/nan
+            return (uint16_t) (sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+        exponent = exponent - 127 + 15;
+        if (exponent >= 31) // too large, inf
+            return (uint16_t) (sign | 0x7c00);
+
+        if (exponent <= 0) {
+            // subnormal or zero
+            if (exponent < -10)
+                return (uint16_t) sign;
+            mantissa |= 0x800000;
+            uint32_t shift = (uint32_t) (14 - exponent);
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t midpoint = 1u << (shift - 1);
+            if ((rest > midpoint) || ((rest == midpoint) && (half & 1)))
+                half++;
+            return (uint16_t) (sign | half);
+        }
+
+        // rounding may carry into the exponent, which is still correct
+        uint32_t half = ((uint32_t) exponent << 10) | (mantissa >> 13);
+        uint32_t rest = mantissa & 0x1fff;
+        if ((rest > 0x1000) || ((rest == 0x1000) && (half & 1)))
+            half++;
+        return (uint16_t) (sign | half);
+    }
+
+    static float to_float(uint16_t half) {
+        uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+        uint32_t exponent = (half >> 10) & 0x1f;
+        uint32_t mantissa = half & 0x3ff;
+        uint32_t x;
+
+        if (exponent == 0x1f) {
+            x = sign | 0x7f800000 | (mantissa << 13);
+        } else if (exponent != 0) {
+            x = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+        } else if (mantissa == 0) {
+            x = sign;
+        } else {
+            // subnormal, normalize it
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400)) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            x = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &x, sizeof(float));
+        return value;
+    }
+};
+
+struct Half2 {
+    Half x, y;
+
+    Half2() = default;
+    Half2(glm::vec2 v) : x(v.x), y(v.y) {}
+
+    operator glm::vec2() const { return glm::vec2((float) x, (float) y); }
+};
+
+// 16 bit per component, normalized to [0, 1] in shaders, e.g. for texture
+// coordinates (GLType::UShort4 with normalize = true)
+struct UNorm16x4 {
+    uint16_t x = 0, y = 0, z = 0, w = 0;
+
+    UNorm16x4() = default;
+    UNorm16x4(glm::vec4 v) : x(to_unorm(v.x)), y(to_unorm(v.y)), z(to_unorm(v.z)), w(to_unorm(v.w)) {}
+
+    operator glm::vec4() const { return glm::vec4(x, y, z, w) / 65535.0f; }
+
+    static uint16_t to_unorm(float value) {
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return (uint16_t) (65535.0f * value + 0.5f);
+    }
+};
+
+// 8 bit per channel color, normalized to [0, 1] in shaders
+struct RGBA8 {
+    uint8_t r = 0, g = 0, b = 0, a = 0;
+
+    RGBA8() = default;
+    RGBA8(glm::vec4 color) : 
+        r(to_byte(color.x)), g(to_byte(color.y)), b(to_byte(color.z)), a(to_byte(color.w)) 
+    {}
+
+    operator glm::vec4() const { return glm::vec4(r, g, b, a) / 255.0f; }
+
+    static uint8_t to_byte(float value) {
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return (uint8_t) (255.0f * value + 0.5f);
+    }
+};
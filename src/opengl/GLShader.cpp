@@ -2,6 +2,8 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "GLShader.hpp"
+#include "GLState.hpp"
+#include "core/RenderThread.hpp"
 
 #include <iostream>
 
@@ -18,8 +20,12 @@ GLShader::GLShader(std::initializer_list<const char*> paths)
 }
 
 GLShader::~GLShader() {
+    // a frame in flight may still use it
     if (m_id)
-        glDeleteProgram(m_id);
+        RenderThread::get().run([id = m_id](){
+            glDeleteProgram(id);
+            GLState::get().deleted_program(id);
+        });
 }
 
 bool GLShader::add_source(const char *filepath) {
@@ -76,115 +82,118 @@ bool GLShader::compile() {
     return false;
 }
 
-unsigned int GLShader::get_uniform_location(const std::string &name) const {
-    unsigned int id = glGetUniformLocation(m_id, name.c_str());
+unsigned int GLShader::get_uniform_location(const char* name) const {
+    unsigned int id = glGetUniformLocation(m_id, name);
     if (id == -1)
         std::cout << "Failed to find location of " << name << std::endl;
     return id;
 }
 
-unsigned int GLShader::get_block_index(const std::string &name) const {
-    unsigned int id = glGetUniformBlockIndex(m_id, name.c_str());
+unsigned int GLShader::get_block_index(const char* name) const {
+    unsigned int id = glGetUniformBlockIndex(m_id, name);
     if (id == -1)
         std::cout << "Failed to find block index of " << name << std::endl;
     return id;
 }
 
 void GLShader::bind() {
-    glUseProgram(m_id);
-    m_name_to_slot.clear();
+    GLState::get().use_program(m_id);
     m_texture_slot = 0;
 }
 
-void GLShader::set_uniform(const std::string &name, bool v1) const {
+void GLShader::set_uniform(const char* name, bool v1) const {
     glUniform1i(get_uniform_location(name), v1);
 }
-void GLShader::set_uniform(const std::string &name, bool v1, bool v2) const {
+void GLShader::set_uniform(const char* name, bool v1, bool v2) const {
     glUniform2i(get_uniform_location(name), v1, v2);
 }
-void GLShader::set_uniform(const std::string &name, bool v1, bool v2, bool v3) const {
+void GLShader::set_uniform(const char* name, bool v1, bool v2, bool v3) const {
     glUniform3i(get_uniform_location(name), v1, v2, v3);
 }
-void GLShader::set_uniform(const std::string &name, bool v1, bool v2, bool v3, bool v4) const {
+void GLShader::set_uniform(const char* name, bool v1, bool v2, bool v3, bool v4) const {
     glUniform4i(get_uniform_location(name), v1, v2, v3, v4);
 }
 
-void GLShader::set_uniform(const std::string &name, int v1) const {
+void GLShader::set_uniform(const char* name, int v1) const {
     glUniform1i(get_uniform_location(name), v1);
 }
-void GLShader::set_uniform(const std::string &name, int v1, int v2) const {
+void GLShader::set_uniform(const char* name, int v1, int v2) const {
     glUniform2i(get_uniform_location(name), v1, v2);
 }
-void GLShader::set_uniform(const std::string &name, int v1, int v2, int v3) const {
+void GLShader::set_uniform(const char* name, int v1, int v2, int v3) const {
     glUniform3i(get_uniform_location(name), v1, v2, v3);
 }
-void GLShader::set_uniform(const std::string &name, int v1, int v2, int v3, int v4) const {
+void GLShader::set_uniform(const char* name, int v1, int v2, int v3, int v4) const {
     glUniform4i(get_uniform_location(name), v1, v2, v3, v4);
 }
 
-void GLShader::set_uniform(const std::string &name, float v1) const {
+void GLShader::set_uniform(const char* name, float v1) const {
     glUniform1f(get_uniform_location(name), v1);
 }
-void GLShader::set_uniform(const std::string &name, float v1, float v2) const {
+void GLShader::set_uniform(const char* name, float v1, float v2) const {
     glUniform2f(get_uniform_location(name), v1, v2);
 }
-void GLShader::set_uniform(const std::string &name, float v1, float v2, float v3) const {
+void GLShader::set_uniform(const char* name, float v1, float v2, float v3) const {
     glUniform3f(get_uniform_location(name), v1, v2, v3);
 }
-void GLShader::set_uniform(const std::string &name, float v1, float v2, float v3, float v4) const {
+void GLShader::set_uniform(const char* name, float v1, float v2, float v3, float v4) const {
     glUniform4f(get_uniform_location(name), v1, v2, v3, v4);
 }
 
 
-void GLShader::set_uniform(const std::string &name, glm::mat2 mat) const {
+void GLShader::set_uniform(const char* name, glm::mat2 mat) const {
     glUniformMatrix2fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
-void GLShader::set_uniform(const std::string &name, const glm::mat3& mat) const {
+void GLShader::set_uniform(const char* name, const glm::mat3& mat) const {
     glUniformMatrix3fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
-void GLShader::set_uniform(const std::string &name, const glm::mat4& mat) const {
+void GLShader::set_uniform(const char* name, const glm::mat4& mat) const {
     glUniformMatrix4fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
-void GLShader::set_uniform(const std::string &name, glm::vec2 vec) const {
+void GLShader::set_uniform(const char* name, glm::vec2 vec) const {
     glUniform2fv(get_uniform_location(name), 1, glm::value_ptr(vec));
 }
-void GLShader::set_uniform(const std::string &name, glm::vec3 vec) const {
+void GLShader::set_uniform(const char* name, glm::vec3 vec) const {
     glUniform3fv(get_uniform_location(name), 1, glm::value_ptr(vec));
 }
-void GLShader::set_uniform(const std::string &name, glm::vec4 vec) const {
+void GLShader::set_uniform(const char* name, glm::vec4 vec) const {
     glUniform4fv(get_uniform_location(name), 1, glm::value_ptr(vec));
 }
 
-void GLShader::set_uniform(const std::string &name, glm::ivec2 vec) const {
+void GLShader::set_uniform(const char* name, glm::ivec2 vec) const {
     glUniform2iv(get_uniform_location(name), 1, glm::value_ptr(vec));
 }
-void GLShader::set_uniform(const std::string &name, glm::ivec3 vec) const {
+void GLShader::set_uniform(const char* name, glm::ivec3 vec) const {
     glUniform3iv(get_uniform_location(name), 1, glm::value_ptr(vec));
 }
-void GLShader::set_uniform(const std::string &name, glm::ivec4 vec) const {
+void GLShader::set_uniform(const char* name, glm::ivec4 vec) const {
     glUniform4iv(get_uniform_location(name), 1, glm::value_ptr(vec));
 }
 
-void GLShader::set_uniform(const std::string &name, AbstractGLTexture &texture) {
-    int8_t slot;
-    if (m_name_to_slot.find(name) != m_name_to_slot.end()) {
-        // if the name already has a slot we use that slot
-        slot = m_name_to_slot[name];
-    } else {
-        // if the name is not known we allocate a new slot
-        slot = m_texture_slot++;
-        m_name_to_slot[name] = slot;
+void GLShader::set_uniform(const char* name, AbstractGLTexture &texture) {
+    set_texture(name, texture.get_type(), texture.get_id());
+}
+
+void GLShader::set_texture(const char* name, GLenum target, uint32_t id) {
+    // if the name already has a slot we use that slot
+    int8_t slot = 0;
+    while ((slot < m_texture_slot) && (std::strcmp(m_slot_names[slot], name) != 0))
+        slot++;
 
-        if (slot > m_max_slots) // TODO: improve error type
+    // if the name is not known we allocate a new slot
+    if (slot == m_texture_slot) {
+        if ((slot >= MAX_TEXTURE_SLOTS) || (slot >= m_max_slots)) // TODO: improve error type
             throw std::invalid_argument("No more texture slots available!");
+        m_slot_names[slot] = name;
+        m_texture_slot++;
     }
-    glActiveTexture(GL_TEXTURE0 + slot);
-    texture.bind();
+    GLState::get().active_texture(slot);
+    GLState::get().bind_texture(target, id);
     set_uniform(name, slot);
 }
 
-void GLShader::set_uniform_block(const std::string &name, int trg) const {
+void GLShader::set_uniform_block(const char* name, int trg) const {
     glUniformBlockBinding(m_id, get_block_index(name), trg);
 }
 
@@ -8,6 +8,8 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <array>
+#include <cstring>
 #include <unordered_map>
 
 #include <glm/glm.hpp>
@@ -22,10 +24,13 @@ private:
     std::vector<const char*> m_geometry_shader_filepaths;
     std::vector<const char*> m_fragment_shader_filepaths;
 
-    // For texture management
+    // For texture management, names of the uniforms using each slot. These
+    // are reset on bind() so this does not allocate per frame. Names need to
+    // stay valid until the next bind(), e.g. string literals.
+    static const int8_t MAX_TEXTURE_SLOTS = 32;
     int8_t m_texture_slot = 0; 
     int32_t m_max_slots;
-    std::unordered_map<std::string, int8_t> m_name_to_slot;
+    std::array<const char*, MAX_TEXTURE_SLOTS> m_slot_names;
 
 public:
     GLShader() : 
@@ -45,37 +50,39 @@ public:
     void use() { bind(); };
     void bind();
 
-    void set_uniform(const std::string &name, bool v1) const;
-    void set_uniform(const std::string &name, bool v1, bool v2) const;
-    void set_uniform(const std::string &name, bool v1, bool v2, bool v3) const;
-    void set_uniform(const std::string &name, bool v1, bool v2, bool v3, bool v4) const;
+    void set_uniform(const char* name, bool v1) const;
+    void set_uniform(const char* name, bool v1, bool v2) const;
+    void set_uniform(const char* name, bool v1, bool v2, bool v3) const;
+    void set_uniform(const char* name, bool v1, bool v2, bool v3, bool v4) const;
 
-    void set_uniform(const std::string &name, int v1) const;
-    void set_uniform(const std::string &name, int v1, int v2) const;
-    void set_uniform(const std::string &name, int v1, int v2, int v3) const;
-    void set_uniform(const std::string &name, int v1, int v2, int v3, int v4) const;
+    void set_uniform(const char* name, int v1) const;
+    void set_uniform(const char* name, int v1, int v2) const;
+    void set_uniform(const char* name, int v1, int v2, int v3) const;
+    void set_uniform(const char* name, int v1, int v2, int v3, int v4) const;
 
-    void set_uniform(const std::string &name, float v1) const;
-    void set_uniform(const std::string &name, float v1, float v2) const;
-    void set_uniform(const std::string &name, float v1, float v2, float v3) const;
-    void set_uniform(const std::string &name, float v1, float v2, float v3, float v4) const;
+    void set_uniform(const char* name, float v1) const;
+    void set_uniform(const char* name, float v1, float v2) const;
+    void set_uniform(const char* name, float v1, float v2, float v3) const;
+    void set_uniform(const char* name, float v1, float v2, float v3, float v4) const;
 
-    void set_uniform(const std::string &name, glm::mat2 mat) const;
-    void set_uniform(const std::string &name, const glm::mat3& mat) const;
-    void set_uniform(const std::string &name, const glm::mat4& mat) const;
+    void set_uniform(const char* name, glm::mat2 mat) const;
+    void set_uniform(const char* name, const glm::mat3& mat) const;
+    void set_uniform(const char* name, const glm::mat4& mat) const;
 
-    void set_uniform(const std::string &name, glm::vec2 vec) const;
-    void set_uniform(const std::string &name, glm::vec3 vec) const;
-    void set_uniform(const std::string &name, glm::vec4 vec) const;
+    void set_uniform(const char* name, glm::vec2 vec) const;
+    void set_uniform(const char* name, glm::vec3 vec) const;
+    void set_uniform(const char* name, glm::vec4 vec) const;
 
-    void set_uniform(const std::string &name, glm::ivec2 vec) const;
-    void set_uniform(const std::string &name, glm::ivec3 vec) const;
-    void set_uniform(const std::string &name, glm::ivec4 vec) const;
+    void set_uniform(const char* name, glm::ivec2 vec) const;
+    void set_uniform(const char* name, glm::ivec3 vec) const;
+    void set_uniform(const char* name, glm::ivec4 vec) const;
 
-    void set_uniform(const std::string &name, AbstractGLTexture& texture);
-    void set_uniform(const std::string &name, AbstractGLTexture* texture) { set_uniform(name, *texture); }
+    void set_uniform(const char* name, AbstractGLTexture& texture);
+    // same by GL handle, target is e.g. GL_TEXTURE_2D
+    void set_texture(const char* name, GLenum target, uint32_t id);
+    void set_uniform(const char* name, AbstractGLTexture* texture) { set_uniform(name, *texture); }
 
-    void set_uniform_block(const std::string &name, int trg) const;
+    void set_uniform_block(const char* name, int trg) const;
 
 
 private:
@@ -92,6 +99,6 @@ private:
         std::vector<unsigned int>& ids
     ) const;
     
-    unsigned int get_uniform_location(const std::string &name) const;
-    unsigned int get_block_index(const std::string &name) const;
+    unsigned int get_uniform_location(const char* name) const;
+    unsigned int get_block_index(const char* name) const;
 };
@@ -0,0 +1,120 @@
+#include "GLState.hpp"
+
+GLState& GLState::get() {
+    static GLState state;
+    return state;
+}
+
+void GLState::use_program(uint32_t id) {
+    if (id == m_program) {
+        m_programs_skipped.add();
+        return;
+    }
+    glUseProgram(id);
+    m_program = id;
+}
+
+void GLState::bind_vertex_array(uint32_t id) {
+    if (id == m_vertex_array) {
+        m_vertex_arrays_skipped.add();
+        return;
+    }
+    glBindVertexArray(id);
+    m_vertex_array = id;
+    m_buffers[buffer_index(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+}
+
+void GLState::bind_buffer(GLenum target, uint32_t id) {
+    size_t index = buffer_index(target);
+    if (index == BUFFER_TARGETS) {
+        glBindBuffer(target, id);
+        return;
+    }
+    if (id == m_buffers[index]) {
+        m_buffers_skipped.add();
+        return;
+    }
+    glBindBuffer(target, id);
+    m_buffers[index] = id;
+}
+
+void GLState::bind_buffer_base(GLenum target, uint32_t index, uint32_t id) {
+    // indexed bindings aren't tracked
+    glBindBufferBase(target, index, id);
+    size_t i = buffer_index(target);
+    if (i != BUFFER_TARGETS)
+        m_buffers[i] = id;
+}
+
+void GLState::active_texture(uint32_t unit) {
+    if (unit == m_active_unit) {
+        m_active_texture_skipped.add();
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0 + unit);
+    m_active_unit = unit;
+}
+
+void GLState::bind_texture(GLenum target, uint32_t id) {
+    if (m_active_unit >= TEXTURE_UNITS) {
+        glBindTexture(target, id);
+        return;
+    }
+    // Each unit has a binding per target, but we only remember the last one.
+    // Binding another target doesn't unbind the old one, so that stays
+    // correct, it just misses a skip.
+    TextureBinding& binding = m_textures[m_active_unit];
+    if ((target == binding.target) && (id == binding.id)) {
+        m_textures_skipped.add();
+        return;
+    }
+    glBindTexture(target, id);
+    binding = { target, id };
+}
+
+void GLState::deleted_program(uint32_t id) {
+    if (id == m_program)
+        m_program = UNKNOWN;
+}
+
+void GLState::deleted_vertex_array(uint32_t id) {
+    if (id == m_vertex_array) {
+        m_vertex_array = UNKNOWN;
+        m_buffers[buffer_index(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+}
+
+void GLState::deleted_buffer(uint32_t id) {
+    for (uint32_t& buffer : m_buffers)
+        if (buffer == id)
+            buffer = UNKNOWN;
+}
+
+void GLState::deleted_texture(uint32_t id) {
+    for (TextureBinding& binding : m_textures)
+        if (binding.id == id)
+            binding = TextureBinding();
+}
+
+void GLState::reset() {
+    m_program = UNKNOWN;
+    m_vertex_array = UNKNOWN;
+    m_buffers.fill(UNKNOWN);
+    m_active_unit = UNKNOWN;
+    m_textures.fill(TextureBinding());
+}
+
+size_t GLState::buffer_index(GLenum target) {
+    switch (target) {
+    case GL_ARRAY_BUFFER:               return 0;
+    case GL_ELEMENT_ARRAY_BUFFER:       return 1;
+    case GL_UNIFORM_BUFFER:             return 2;
+    case GL_COPY_READ_BUFFER:           return 3;
+    case GL_COPY_WRITE_BUFFER:          return 4;
+    case GL_PIXEL_PACK_BUFFER:          return 5;
+    case GL_PIXEL_UNPACK_BUFFER:        return 6;
+    case GL_TEXTURE_BUFFER:             return 7;
+    case GL_TRANSFORM_FEEDBACK_BUFFER:  return 8;
+    default:                            return BUFFER_TARGETS;
+    }
+}
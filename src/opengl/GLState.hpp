@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <glad/gl.h>
+
+#include "core/Metrics.hpp"
+
+// Shadow copy of the GL bindings of the (only) context, so that binding
+// what is already bound is skipped. The opengl wrappers bind through this,
+// anything calling glBind* or glUseProgram directly (e.g. ImGui) has to
+// reset() afterwards. Only touch it from the thread owning the context.
+//
+// Tracks the program, vertex array, buffer per target and texture per unit.
+// The ELEMENT_ARRAY_BUFFER binding is part of the vertex array, so it
+// becomes unknown whenever the vertex array changes.
+class GLState {
+private:
+    static constexpr uint32_t UNKNOWN = ~0u;
+    static constexpr size_t BUFFER_TARGETS = 9;
+    // units past this are always bound
+    static constexpr size_t TEXTURE_UNITS = 32;
+
+    struct TextureBinding {
+        GLenum target = 0;
+        uint32_t id = UNKNOWN;
+    };
+
+    uint32_t m_program = UNKNOWN;
+    uint32_t m_vertex_array = UNKNOWN;
+    std::array<uint32_t, BUFFER_TARGETS> m_buffers;
+    uint32_t m_active_unit = UNKNOWN;
+    std::array<TextureBinding, TEXTURE_UNITS> m_textures;
+
+    Metrics::Counter& m_programs_skipped = Metrics::counter("GLState/programs skipped");
+    Metrics::Counter& m_vertex_arrays_skipped = Metrics::counter("GLState/vertex arrays skipped");
+    Metrics::Counter& m_buffers_skipped = Metrics::counter("GLState/buffers skipped");
+    Metrics::Counter& m_textures_skipped = Metrics::counter("GLState/textures skipped");
+    Metrics::Counter& m_active_texture_skipped = Metrics::counter("GLState/active texture skipped");
+
+    GLState() { reset(); }
+
+public:
+    GLState(const GLState&) = delete;
+    GLState& operator=(const GLState&) = delete;
+
+    static GLState& get();
+
+    void use_program(uint32_t id);
+    void bind_vertex_array(uint32_t id);
+    void bind_buffer(GLenum target, uint32_t id);
+    // Also binds the generic target
+    void bind_buffer_base(GLenum target, uint32_t index, uint32_t id);
+    // unit counts from 0, i.e. GL_TEXTURE0 + unit
+    void active_texture(uint32_t unit);
+    // Binds to the active unit
+    void bind_texture(GLenum target, uint32_t id);
+
+    // Names get reused after glDelete*, forget them
+    void deleted_program(uint32_t id);
+    void deleted_vertex_array(uint32_t id);
+    void deleted_buffer(uint32_t id);
+    void deleted_texture(uint32_t id);
+
+    // Forgets everything, after GL state was changed behind our back
+    void reset();
+
+private:
+    static size_t buffer_index(GLenum target);
+};
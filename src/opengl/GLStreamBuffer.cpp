@@ -0,0 +1,108 @@
+#include "GLStreamBuffer.hpp"
+#include "GLState.hpp"
+#include "core/RenderThread.hpp"
+
+#include <algorithm>
+#include <array>
+
+GLStreamBuffer::GLStreamBuffer(size_t section_size, Mode mode)
+    : GLVertexBuffer(buffer_size(section_size, mode), GLBuffer::STREAM_DRAW), m_section_size(section_size)
+{
+    // replace the mutable storage with persistently mapped storage if we can
+    if ((mode == PERSISTENT) && GLAD_GL_VERSION_4_4) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bind();
+        glBufferStorage(m_buffer_type, m_size, nullptr, flags);
+        m_mapped = static_cast<uint8_t*>(glMapBufferRange(m_buffer_type, 0, m_size, flags));
+        m_persistent = m_mapped != nullptr;
+        if (!m_persistent)
+            std::cout << "Failed to map stream buffer, falling back to orphaning." << std::endl;
+    }
+}
+
+GLStreamBuffer::~GLStreamBuffer() {
+    // runs before GLBuffer deletes the buffer
+    std::array<GLsync, SECTIONS> fences;
+    std::copy(std::begin(m_fences), std::end(m_fences), fences.begin());
+    bool mapped = m_mapped || m_reserved;
+    RenderThread::get().run([fences, mapped, type = m_buffer_type, id = m_id](){
+        for (GLsync fence : fences)
+            if (fence)
+                glDeleteSync(fence);
+        if (mapped) {
+            GLState::get().bind_buffer(type, id);
+            glUnmapBuffer(type);
+        }
+    });
+}
+
+void* GLStreamBuffer::allocate(size_t bytes, size_t& offset) {
+    if (!m_persistent || (m_record_offset + bytes > m_section_size))
+        return nullptr;
+    offset = m_record_section * m_section_size + m_record_offset;
+    m_record_offset += bytes;
+    m_written.add(bytes);
+    return m_mapped + offset;
+}
+
+uint32_t GLStreamBuffer::close_frame() {
+    uint32_t section = m_record_section;
+    m_record_section = (m_record_section + 1) % SECTIONS;
+    m_record_offset = 0;
+    return section;
+}
+
+void GLStreamBuffer::end_frame(uint32_t section) {
+    if (!m_persistent)
+        return;
+    if (m_fences[section])
+        glDeleteSync(m_fences[section]);
+    m_fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // Recording is in section + 1 while this frame executes, and moves on
+    // to section + 2 once it's done. Whatever the GPU still reads from there
+    // is from the previous frame.
+    GLsync& fence = m_fences[(section + 2) % SECTIONS];
+    if (fence) {
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED)) {
+            m_waits.add();
+            while (true) {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                if ((result == GL_ALREADY_SIGNALED) || (result == GL_CONDITION_SATISFIED) || (result == GL_WAIT_FAILED))
+                    break;
+            }
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void* GLStreamBuffer::reserve(size_t bytes) {
+    // Orphaning: the driver hands us fresh storage while the GPU keeps the
+    // old one. Until then appended ranges don't need synchronization.
+    bind();
+    if (m_offset + bytes > m_size) {
+        glBufferData(m_buffer_type, m_size, nullptr, m_mode);
+        m_offset = 0;
+        m_orphans.add();
+    }
+    m_reserved = bytes;
+    return glMapBufferRange(m_buffer_type, m_offset, bytes, 
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+    );
+}
+
+size_t GLStreamBuffer::commit(size_t bytes) {
+    bind();
+    glUnmapBuffer(m_buffer_type);
+    m_reserved = 0;
+    size_t offset = m_offset;
+    m_offset += bytes;
+    m_written.add(bytes);
+    return offset;
+}
+
+size_t GLStreamBuffer::buffer_size(size_t section_size, Mode mode) {
+    return ((mode == PERSISTENT) && GLAD_GL_VERSION_4_4) ? SECTIONS * section_size : section_size;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include "GLVertexArray.hpp"
+#include "core/Metrics.hpp"
+
+// Vertex buffer for data that gets rewritten every frame. Data is written
+// straight into mapped memory, the returned offset is where it starts in
+// the buffer, i.e. draw with first = offset / stride.
+//
+// With GL 4.4 the buffer is split into SECTIONS parts which are persistently
+// mapped (glBufferStorage), one per recorded frame. The recording thread
+// allocate()s ranges of the current section, anyone may fill them (e.g.
+// jobs), and close_frame() moves on to the next section. The GL thread calls
+// end_frame(section) after the last draw of that frame, which fences the
+// section and waits until the GPU is done with the section that gets
+// recorded after the next one. That relies on recording being at most one
+// frame ahead of the GL thread, see RenderThread.
+//
+// Without 4.4 (or with ORPHANING) allocate() always fails. The GL thread
+// reserve()s space, writes it and commit()s how much it wrote. Ranges get
+// mapped unsynchronized and the buffer is orphaned when full, so issue the
+// draws reading a reserve() before the next reserve().
+class GLStreamBuffer : public GLVertexBuffer {
+public:
+    enum Mode { PERSISTENT, ORPHANING };
+
+private:
+    static const uint32_t SECTIONS = 3;
+    static_assert(SECTIONS >= 3, "One section recorded, one drawn, one in flight on the GPU.");
+
+    size_t m_section_size;
+    bool m_persistent = false;
+    uint8_t* m_mapped = nullptr;
+
+    // recording thread
+    uint32_t m_record_section = 0;
+    size_t m_record_offset = 0;
+
+    // GL thread
+    GLsync m_fences[SECTIONS] = {};
+    // orphaning: write offset in the buffer and size of the mapped range
+    size_t m_offset = 0;
+    size_t m_reserved = 0;
+
+    Metrics::Counter& m_written = Metrics::counter("GLStreamBuffer/bytes written");
+    Metrics::Counter& m_waits = Metrics::counter("GLStreamBuffer/fence waits");
+    Metrics::Counter& m_orphans = Metrics::counter("GLStreamBuffer/orphans");
+
+public:
+    // section_size is the data of a frame (persistent) or the whole buffer
+    // (orphaning), it should be a multiple of the vertex size. PERSISTENT
+    // falls back to ORPHANING without GL 4.4.
+    GLStreamBuffer(size_t section_size, Mode mode = PERSISTENT);
+    ~GLStreamBuffer();
+
+    bool is_persistent() const { return m_persistent; }
+
+    // Recording thread. Returns memory for `bytes` in the section of the
+    // recorded frame and sets `offset`, nullptr if the section is full or
+    // the buffer isn't persistent. The memory is write combined, don't read
+    // it back.
+    void* allocate(size_t bytes, size_t& offset);
+    // Ends the recorded frame, returns its section for end_frame()
+    uint32_t close_frame();
+
+    // GL thread. Fences `section`, call after the last draw of its frame.
+    void end_frame(uint32_t section);
+
+    // GL thread, orphaning only. Returns memory for at most `bytes`
+    // (<= section_size) of vertex data.
+    void* reserve(size_t bytes);
+    // Finishes a reserve(), returns the byte offset of the data in the buffer
+    size_t commit(size_t bytes);
+
+private:
+    static size_t buffer_size(size_t section_size, Mode mode);
+};
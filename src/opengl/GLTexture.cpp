@@ -1,4 +1,6 @@
 #include "GLTexture.hpp"
+#include "GLState.hpp"
+#include "core/RenderThread.hpp"
 
 #include <iostream>
 
@@ -9,15 +11,19 @@ AbstractGLTexture::AbstractGLTexture(GLenum texture_type) : m_texture_type(textu
 }
 
 AbstractGLTexture::~AbstractGLTexture() {
-    glDeleteTextures(1, &m_id);
+    // a frame in flight may still use it
+    RenderThread::get().run([id = m_id](){
+        glDeleteTextures(1, &id);
+        GLState::get().deleted_texture(id);
+    });
 };
 
 void AbstractGLTexture::bind() const {
-    glBindTexture(m_texture_type, m_id);
+    GLState::get().bind_texture(m_texture_type, m_id);
 }
 
 void AbstractGLTexture::unbind() const {
-    glBindTexture(m_texture_type, 0);
+    GLState::get().bind_texture(m_texture_type, 0);
 }
 
 unsigned int AbstractGLTexture::get_id() const {
@@ -130,6 +136,40 @@ void GLTexture::set_data(GLenum gl_type, void* data, GLenum format, size_t width
         generate_mipmap();
 }
 
+// GLTextureArray
+
+GLTextureArray::GLTextureArray() : AbstractGLTexture(GL_TEXTURE_2D_ARRAY)
+{
+    set_wrapping(WRAP_X, GL_CLAMP_TO_EDGE);
+    set_wrapping(WRAP_Y, GL_CLAMP_TO_EDGE);
+    set_min_filter(LINEAR);
+    set_mag_filter(LINEAR);
+}
+
+void GLTextureArray::allocate(size_t width, size_t height, size_t layers) {
+    bind();
+    m_width = width;
+    m_height = height;
+    m_layers = layers;
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, m_internal_format, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+}
+
+void GLTextureArray::set_layer(size_t layer, GLenum gl_type, void* data, GLenum format, size_t width, size_t height) {
+    if ((layer >= m_layers) || (width > m_width) || (height > m_height)) {
+        std::cout << "Texture data does not fit GLTextureArray layer " << layer << std::endl;
+        return;
+    }
+
+    bind();
+    // rows of e.g. RGB data are not necessarily 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, gl_type, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (m_mipmapped)
+        generate_mipmap();
+}
+
 // Cubemap
 
 GLCubeMap::GLCubeMap() : AbstractGLTexture(GL_TEXTURE_CUBE_MAP)
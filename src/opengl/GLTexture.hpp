@@ -47,6 +47,7 @@ public:
     virtual void bind() const;
     virtual void unbind() const;
     unsigned int get_id() const;
+    GLenum get_type() const { return m_texture_type; }
 
     void set_min_filter(GLenum mode) const; // combined filter type
     void set_min_filter(GLenum main, GLenum mipmap) const; // separate filter types
@@ -102,6 +103,36 @@ private:
 };
 
 
+// A stack of equally sized 2D textures which can be bound as one, e.g. to
+// draw differently textured things in one draw call. Layers are indexed by
+// the third texture coordinate in the shader (sampler2DArray).
+class GLTextureArray : public AbstractGLTexture {
+private:
+    size_t m_width = 0, m_height = 0, m_layers = 0;
+
+public:
+    GLTextureArray();
+
+    // Allocates storage for `layers` textures of width x height, this drops
+    // the current content
+    void allocate(size_t width, size_t height, size_t layers);
+
+    template <typename T>
+    void set_layer(size_t layer, T* data, GLenum format, size_t width, size_t height) {
+        GLenum gl_type = gl_type_convert<T>();
+        set_layer(layer, gl_type, (void*) data, format, width, height);
+    }
+
+    // Writes width x height (at most the allocated size) texels to the bottom
+    // left of `layer`
+    void set_layer(size_t layer, GLenum gl_type, void* data, GLenum format, size_t width, size_t height);
+
+    size_t width() const { return m_width; }
+    size_t height() const { return m_height; }
+    size_t layers() const { return m_layers; }
+};
+
+
 class GLCubeMap : public AbstractGLTexture {
 public:
     enum : GLenum {
@@ -1,35 +1,53 @@
 
 #include "GLVertexArray.hpp"
+#include "GLState.hpp"
+#include "core/Metrics.hpp"
+#include "core/RenderThread.hpp"
 
 // Generic buffer
 GLBuffer::GLBuffer(GLenum buffer_type, void* vertices, size_t bytesize, unsigned int mode)
     : m_buffer_type(buffer_type), m_mode(mode), m_size(bytesize)
 {
     glGenBuffers(1, &m_id);
-    glBindBuffer(m_buffer_type, m_id);
-    glBufferData(m_buffer_type, m_size, vertices, m_mode);
+    // Uploads go through the copy target, binding an index buffer would
+    // change the bound vertex array
+    GLState::get().bind_buffer(GL_COPY_WRITE_BUFFER, m_id);
+    glBufferData(GL_COPY_WRITE_BUFFER, m_size, vertices, m_mode);
 }
 
 GLBuffer::~GLBuffer() {
-    glDeleteBuffers(1, &m_id);
+    // a frame in flight may still use it
+    RenderThread::get().run([id = m_id](){
+        glDeleteBuffers(1, &id);
+        GLState::get().deleted_buffer(id);
+    });
 }
 
 void GLBuffer::set_data(const void* vertices, unsigned int bytesize) {
-    bind();
+    static Metrics::Counter& uploaded = Metrics::counter("GLBuffer/bytes uploaded");
+    GLState::get().bind_buffer(GL_COPY_WRITE_BUFFER, m_id);
     m_size = bytesize;
-    glBufferSubData(m_buffer_type, 0, m_size, vertices);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, m_size, vertices);
+    uploaded.add(bytesize);
+}
+
+void GLBuffer::set_data(const void* vertices, size_t offset, size_t bytesize) {
+    static Metrics::Counter& uploaded = Metrics::counter("GLBuffer/bytes uploaded");
+    GLState::get().bind_buffer(GL_COPY_WRITE_BUFFER, m_id);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytesize, vertices);
+    uploaded.add(bytesize);
 }
 
 void GLBuffer::bind() const {
-    glBindBuffer(m_buffer_type, m_id);
+    GLState::get().bind_buffer(m_buffer_type, m_id);
 }
 
 void GLBuffer::unbind() const {
-    glBindBuffer(m_buffer_type, 0);
+    GLState::get().bind_buffer(m_buffer_type, 0);
 }
 
 void GLBuffer::bind_buffer_base(uint32_t index) const {
-	glBindBufferBase(m_buffer_type, index, m_id);
+	GLState::get().bind_buffer_base(m_buffer_type, index, m_id);
 }
 
 
@@ -52,21 +70,67 @@ GLVertexArray::GLVertexArray()
 }
 
 GLVertexArray::~GLVertexArray() {
-    glDeleteVertexArrays(1, &m_id);
+    RenderThread::get().run([id = m_id](){
+        glDeleteVertexArrays(1, &id);
+        GLState::get().deleted_vertex_array(id);
+    });
 }
 
 void GLVertexArray::set(std::shared_ptr<GLIndexBuffer> indices) {
     m_indices = indices;
+    // the index buffer binding is stored in the vertex array
+    bind();
+    m_indices->bind();
 }
 
-void GLVertexArray::push(std::shared_ptr<GLVertexBuffer> buffer) {
+void GLVertexArray::unbind() {
+    GLState::get().bind_vertex_array(0);
+}
+
+void GLVertexArray::push(std::shared_ptr<GLVertexBuffer> buffer, uint32_t divisor) {
     bind();
 	buffer->bind();
-	GLBufferLayout layout = buffer->get_layout();
+	m_locations.push_back(m_buffer_idx);
+	m_divisors.push_back(divisor);
+	m_buffer_idx = set_pointers(buffer->get_layout(), m_buffer_idx, 0, divisor);
+	m_buffers.push_back(buffer);
+}
+
+void GLVertexArray::set_offset(size_t idx, size_t offset) const {
+	// the buffer bound to GL_ARRAY_BUFFER gets captured by glVertexAttribPointer
+	bind();
+	m_buffers[idx]->bind();
+	set_pointers(m_buffers[idx]->get_layout(), m_locations[idx], offset, m_divisors[idx]);
+}
 
+unsigned int GLVertexArray::set_pointers(const GLBufferLayout& layout, unsigned int location, size_t offset, uint32_t divisor) const {
 	for (const GLBufferElement& element : layout) {
+		// normalized integers are floats in the shader
+		if (element.normalize && is_integer_type(element.type)) {
+			glEnableVertexAttribArray(location);
+			glVertexAttribPointer(
+				location,
+				element.component_count(),
+				gl_native_type(element.type),
+				GL_TRUE,
+				layout.get_stride(),
+				(const void*)(offset + element.offset)
+			);
+			glVertexAttribDivisor(location, divisor);
+			location++;
+			continue;
+		}
+
 		switch (element.type) {
 			case GLType::Bool:
+			case GLType::UByte:
+			case GLType::UByte2:
+			case GLType::UByte3:
+			case GLType::UByte4:
+			case GLType::Byte:
+			case GLType::Byte2:
+			case GLType::Byte3:
+			case GLType::Byte4:
 			case GLType::Int:
 			case GLType::Int2:
 			case GLType::Int3:
@@ -80,32 +144,38 @@ void GLVertexArray::push(std::shared_ptr<GLVertexBuffer> buffer) {
 			case GLType::UShort3:
 			case GLType::UShort4:
 			{
-				glEnableVertexAttribArray(m_buffer_idx);
+				glEnableVertexAttribArray(location);
 				glVertexAttribIPointer(
-					m_buffer_idx,                   // layout location in shader
+					location,                       // layout location in shader
 					element.component_count(),      // number of values in "vertex" element
 					gl_native_type(element.type),   // GL<type>
 					layout.get_stride(),            // length of "vertex"
-					(const void*)element.offset     // offset of first value in "vertex" element
+					(const void*)(offset + element.offset) // offset of first value in "vertex" element
 				);
-				m_buffer_idx++;
+				glVertexAttribDivisor(location, divisor);
+				location++;
 				break;
 			}
+			case GLType::Half:
+			case GLType::Half2:
+			case GLType::Half3:
+			case GLType::Half4:
 			case GLType::Float: 
 			case GLType::Float2:
 			case GLType::Float3:
 			case GLType::Float4:
 			{
-				glEnableVertexAttribArray(m_buffer_idx);
+				glEnableVertexAttribArray(location);
 				glVertexAttribPointer(
-					m_buffer_idx,
+					location,
 					element.component_count(),
 					gl_native_type(element.type),
 					element.normalize ? GL_TRUE : GL_FALSE,  // normalize first, or convert to fixed point data directly (if applicable?)
 					layout.get_stride(),
-					(const void*)element.offset
+					(const void*)(offset + element.offset)
 				);
-				m_buffer_idx++;
+				glVertexAttribDivisor(location, divisor);
+				location++;
 				break;
 			}
 			case GLType::Mat3:
@@ -114,16 +184,17 @@ void GLVertexArray::push(std::shared_ptr<GLVertexBuffer> buffer) {
 				size_t count = element.component_count();
 				for (size_t i = 0; i < count; i++)
 				{
-					glEnableVertexAttribArray(m_buffer_idx);
+					glEnableVertexAttribArray(location);
 					glVertexAttribPointer(
-						m_buffer_idx,
+						location,
 						count,
 						gl_native_type(element.type),
 						element.normalize ? GL_TRUE : GL_FALSE,
 						layout.get_stride(),
-						(const void*)(element.offset + sizeof(float) * count * i)
+						(const void*)(offset + element.offset + sizeof(float) * count * i)
 					);
-					m_buffer_idx++;
+					glVertexAttribDivisor(location, divisor);
+					location++;
 				}
 				break;
 			}
@@ -131,14 +202,11 @@ void GLVertexArray::push(std::shared_ptr<GLVertexBuffer> buffer) {
 				std::cout << "Failed to convert unknown GLType" << std::endl;
 		}
 	}
-
-	m_buffers.push_back(buffer);
+	return location;
 }
 
 void GLVertexArray::bind() const {
-    glBindVertexArray(m_id);
-	if (m_indices)
-		m_indices->bind();
+    GLState::get().bind_vertex_array(m_id);
 }
 
 void GLVertexArray::update(size_t idx, void* data, size_t size) const {
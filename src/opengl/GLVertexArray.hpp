@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <memory>
 #include <vector>
 
 #include <glad/gl.h>
@@ -49,6 +50,8 @@ public:
 	virtual ~GLBuffer();
 
 	void set_data(const void* vertices, unsigned int size);
+	// Updates part of the buffer, keeps the size
+	void set_data(const void* vertices, size_t offset, size_t bytesize);
 	void bind() const;
 	void unbind() const;
 	void bind_buffer_base(uint32_t index) const;
@@ -110,17 +113,29 @@ private:
 	std::shared_ptr<GLIndexBuffer> m_indices;
 	std::vector<std::shared_ptr<GLVertexBuffer>> m_buffers;
 	unsigned int m_buffer_idx; // number of buffers
+	// first attribute location and instance divisor per buffer
+	std::vector<unsigned int> m_locations;
+	std::vector<uint32_t> m_divisors;
 
 public:
 	GLVertexArray();
 	~GLVertexArray();
 
 	void set(std::shared_ptr<GLIndexBuffer> indices);
-	void push(std::shared_ptr<GLVertexBuffer> buffer);
+	// divisor > 0 makes the buffer per instance (advances every divisor instances)
+	void push(std::shared_ptr<GLVertexBuffer> buffer, uint32_t divisor = 0);
 	void bind() const;
-	static void unbind() { glBindVertexArray(0); }
+	static void unbind();
+	unsigned int get_id() const { return m_id; }
 	uint32_t index_count() const { return m_indices->count(); }
 
 	void update(size_t idx, void* data, size_t size) const;
 	void set_layout(size_t idx, const GLBufferLayout& layout) const;
+	// Points the attributes of buffer idx `offset` bytes into the buffer, e.g.
+	// to draw instances from the middle of a stream buffer. (There is no
+	// baseinstance in GL 3.3.)
+	void set_offset(size_t idx, size_t offset) const;
+
+private:
+	unsigned int set_pointers(const GLBufferLayout& layout, unsigned int location, size_t offset, uint32_t divisor) const;
 };
\ No newline at end of file
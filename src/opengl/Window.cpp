@@ -1,9 +1,11 @@
 #include "Window.hpp"
+#include "core/RenderThread.hpp"
 
 #include <iostream>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+    // events are polled on the main thread
+    RenderThread::get().run([width, height](){ glViewport(0, 0, width, height); });
 }
 
 bool Window::init() {
@@ -83,11 +85,15 @@ bool Window::is_mouse_button_pressed(MouseCode button) const {
 }
 
 void Window::set_vsync(bool active) const {
-    activate(); // for savety
-    glfwSwapInterval(active ? 1 : 0);
+    // needs the context
+    RenderThread::get().run([this, active](){
+        activate(); // for savety
+        glfwSwapInterval(active ? 1 : 0);
+    });
 }
 
 void Window::set_size(int width, int height) {
-    activate(); // for savety
+    // main thread only, activating the context here would take it from the
+    // render thread
     glfwSetWindowSize(m_window, width, height);
 }
\ No newline at end of file
@@ -58,20 +58,22 @@ namespace Component {
             }
         };
 
+        // Only geometry, collision loops touch nothing else. What happens on
+        // a collision is in CollisionHandler.
         BoundingShape bbox;
-        Callback::Function2 on_collision = Callback::do_nothing2;
 
-        Boundingbox2D(float l, float r, float b, float t, Callback::Function2 cb = Callback::do_nothing2)
-            : bbox(BoundingShape(l, r, b, t)), on_collision(cb) 
+        Boundingbox2D() : bbox(BoundingShape(Rect2D)) {}
+        Boundingbox2D(float l, float r, float b, float t)
+            : bbox(BoundingShape(l, r, b, t))
         {}
-        Boundingbox2D(glm::vec2 p, float r, Callback::Function2 cb = Callback::do_nothing2)
-            : bbox(BoundingShape(p, r)), on_collision(cb)
+        Boundingbox2D(glm::vec2 p, float r)
+            : bbox(BoundingShape(p, r))
         {}
-        Boundingbox2D(uint8_t shape, Callback::Function2 cb = Callback::do_nothing2)
-            : bbox(BoundingShape(shape)), on_collision(cb)
+        Boundingbox2D(uint8_t shape)
+            : bbox(BoundingShape(shape))
         {}
 
-        glm::vec4 get_raw_lrbt() {
+        glm::vec4 get_raw_lrbt() const {
             switch (bbox.shape) {
             case Component::Boundingbox2D::Rect2D:
                 return glm::vec4(bbox.left, bbox.right, bbox.bottom, bbox.top);
@@ -82,7 +84,7 @@ namespace Component {
                 return glm::vec4(0);
             }
         }
-        glm::vec4 get_lrbt(Component::Transform& transform) {
+        glm::vec4 get_lrbt(const Component::Transform2D& transform) const {
             glm::vec4 lrbt = get_raw_lrbt();
             lrbt.x = transform.scale.x * lrbt.x + transform.position.x;
             lrbt.y = transform.scale.x * lrbt.y + transform.position.x;
@@ -91,4 +93,15 @@ namespace Component {
             return lrbt;
         }
     };
+
+    // Called with (this, other) when the Boundingbox2D of this entity
+    // intersects another one
+    struct CollisionHandler {
+        // id in Callback::Registry, 0 does nothing
+        entt::id_type callback = 0;
+
+        CollisionHandler() = default;
+        CollisionHandler(const CollisionHandler&) = default;
+        CollisionHandler(entt::id_type cb) : callback(cb) {}
+    };
 }
\ No newline at end of file
@@ -5,9 +5,10 @@
 namespace Component {
     // This enables movement simulation
     struct Motion {
-        glm::vec3 velocity;
-        glm::vec3 acceleration;
+        glm::vec3 velocity = glm::vec3(0);
+        glm::vec3 acceleration = glm::vec3(0);
         
+        Motion() = default;
         Motion(glm::vec3 v, glm::vec3 a = glm::vec3(0))
             : velocity(v), acceleration(a)
         {}
@@ -1,83 +1,122 @@
 #pragma once
 
+#include <cassert>
+#include <iostream>
 #include <limits>
+#include <vector>
 
 #include <entt/entt.hpp>
 
 #include "Motion.hpp"
 #include "BoundingBox2D.hpp"
+#include "core/FrameArena.hpp"
+#include "core/Metrics.hpp"
+#include "Scene/AbstractScene.hpp"
+#include "Scene/SpatialGrid2D.hpp"
 
 class Physics2D {
 private:
     entt::registry* m_registry = nullptr;
+    // world space boxes of group<Transform2D, Boundingbox2D>, in group order
+    std::vector<glm::vec4> m_lrbt;
+    // broadphase over m_lrbt, ids and items are indices
+    SpatialGrid2D m_grid;
+    Metrics::Counter& m_pairs_tested = Metrics::counter("Physics2D/pairs tested");
+    Metrics::Counter& m_collisions = Metrics::counter("Physics2D/collisions");
 
 public:
-    void init(entt::registry& reg) {
-        m_registry = &reg;
+    static inline const entt::id_type REFLECT = Callback::Registry::id("Physics2D/reflect");
+
+    void init(AbstractScene& scene) {
+        m_registry = &scene.get_registry();
+        scene.get_callbacks().add("Physics2D/reflect", (Callback::Function2) resolve_reflection);
+
+        // collision tests are quadratic, so the fully packed group goes there
+        scene.declare_group<Component::Transform2D, Component::Boundingbox2D>();
+        scene.declare_group<Component::Motion>(entt::get<Component::Transform2D>);
     }
 
 // Systems
 
     void resolve_motion(float delta_time) const {
-        auto view = m_registry->view<Component::Transform, Component::Motion>();
-        for (entt::entity e : view) {
-            auto [transform, motion] = view.get(e);
+        auto group = m_registry->group<Component::Motion>(entt::get<Component::Transform2D>);
+        for (auto [e, motion, transform] : group.each())
             transform.translate_by(motion.update(delta_time));
-        }
     }
 
     // TODO: Optimize:
     // - double work from not advancing inner loop
-    // - better filtering options? e.g. fast skip?
-    void resolve_collisions() const {
-        auto view = m_registry->view<Component::Motion, Component::Transform, Component::Boundingbox2D>();
-        for (entt::entity main : view)
-            resolve_collisions(main);
-    }
-
-    void resolve_collisions(entt::entity main) const {
-        auto [m_transform, m_bbox] = m_registry->get<Component::Transform, Component::Boundingbox2D>(main);
-        glm::vec4 m_lrbt = m_bbox.get_lrbt(m_transform);
-
-        auto view = m_registry->view<Component::Transform, Component::Boundingbox2D>();
-        for (entt::entity other : view) {
-            if (main == other)
+    void resolve_collisions() {
+        auto group = m_registry->group<Component::Transform2D, Component::Boundingbox2D>();
+        auto& motions = m_registry->storage<Component::Motion>();
+        update_boxes(group);
+
+        // Broadphase, boxes moved by reflections below get moved in the grid
+        // too (see update_box)
+        m_grid.clear();
+        m_grid.reserve(m_lrbt.size());
+        for (size_t i = 0; i < m_lrbt.size(); i++)
+            m_grid.insert((uint32_t) i, m_lrbt[i]);
+
+        // Owned storages are packed in group order, same as m_lrbt. These
+        // stay valid as long as handlers defer structural changes through
+        // the scene's CommandBuffer.
+        auto& transforms = m_registry->storage<Component::Transform2D>();
+        const entt::entity* entities = transforms.data();
+        const size_t count = m_lrbt.size();
+        uint64_t tested = 0;
+        // grid query results, handlers only run after the query
+        FrameVector<uint32_t> candidates(FrameArena::get().allocator());
+        for (size_t i = 0; i < count; i++) {
+            if (!motions.contains(entities[i]))
                 continue;
 
-            auto [o_transform, o_bbox] = view.get(other);
-            glm::vec4 o_lrbt = o_bbox.get_lrbt(o_transform);
-
-            if (intersects(m_lrbt, o_lrbt)) {
-                m_bbox.on_collision(Entity(m_registry, main), Entity(m_registry, other));
-                o_bbox.on_collision(Entity(m_registry, other), Entity(m_registry, main));
+            // the grid can't change while it is queried
+            candidates.clear();
+            m_grid.query(m_lrbt[i], [&](uint32_t j){
+                if (i != j)
+                    candidates.push_back(j);
+            });
+
+            for (uint32_t j : candidates) {
+                tested++;
+                if (intersects(m_lrbt[i], m_lrbt[j])) {
+                    call_handlers(entities[i], entities[j]);
+                    if ((group.size() != count) || (transforms.data() != entities)) {
+                        assert(false && "Collision handlers must defer structural changes.");
+                        std::cout << "Collision handler changed the registry structure, use the CommandBuffer. Skipping the remaining collisions." << std::endl;
+                        m_pairs_tested.add(tested);
+                        return;
+                    }
+                    // reflections may have moved them
+                    update_box(i, entities[i]);
+                    update_box(j, entities[j]);
+                }
             }
         }
+        m_pairs_tested.add(tested);
     }
 
     void resolve_collisions(entt::entity main, entt::entity other) const {
         if (main == other)
             return;
 
-        auto [m_transform, m_bbox] = m_registry->get<Component::Transform, Component::Boundingbox2D>(main);
-        glm::vec4 m_lrbt = m_bbox.get_lrbt(m_transform);
-        
-        auto [o_transform, o_bbox] = m_registry->get<Component::Transform, Component::Boundingbox2D>(other);
-        glm::vec4 o_lrbt = o_bbox.get_lrbt(o_transform);
+        auto [m_transform, m_bbox] = m_registry->get<Component::Transform2D, Component::Boundingbox2D>(main);
+        auto [o_transform, o_bbox] = m_registry->get<Component::Transform2D, Component::Boundingbox2D>(other);
+        m_pairs_tested.add();
 
-        if (intersects(m_lrbt, o_lrbt)) {
-            m_bbox.on_collision(Entity(m_registry, main), Entity(m_registry, other));
-            o_bbox.on_collision(Entity(m_registry, other), Entity(m_registry, main));
-        }
+        if (intersects(m_bbox.get_lrbt(m_transform), o_bbox.get_lrbt(o_transform)))
+            call_handlers(main, other);
     }
 
 // Resolving Collisions
 
     static const void resolve_reflection(Entity a, Entity b) {
 
-        auto [a_transform, a_bbox, a_motion] = a.get<Component::Transform, Component::Boundingbox2D, Component::Motion>();
+        auto [a_transform, a_bbox, a_motion] = a.get<Component::Transform2D, Component::Boundingbox2D, Component::Motion>();
         glm::vec4 a_lrbt = a_bbox.get_lrbt(a_transform);
         
-        auto [b_transform, b_bbox] = b.get<Component::Transform, Component::Boundingbox2D>();
+        auto [b_transform, b_bbox] = b.get<Component::Transform2D, Component::Boundingbox2D>();
         glm::vec4 b_lrbt = b_bbox.get_lrbt(b_transform);
 
         glm::vec3 vel = a_motion.velocity, accel = a_motion.acceleration;
@@ -126,6 +165,34 @@ public:
 
 // Utilities/Internals
 
+    template <typename Group>
+    void update_boxes(const Group& group) {
+        auto& transforms = m_registry->storage<Component::Transform2D>();
+        auto& bboxes = m_registry->storage<Component::Boundingbox2D>();
+        const entt::entity* entities = transforms.data();
+
+        m_lrbt.resize(group.size());
+        for (size_t i = 0; i < m_lrbt.size(); i++)
+            m_lrbt[i] = bboxes.get(entities[i]).get_lrbt(transforms.get(entities[i]));
+    }
+
+    void update_box(size_t index, entt::entity e) {
+        auto [transform, bbox] = m_registry->get<Component::Transform2D, Component::Boundingbox2D>(e);
+        m_lrbt[index] = bbox.get_lrbt(transform);
+        m_grid.move((uint32_t) index, m_lrbt[index]);
+    }
+
+    // Handlers are only looked up for actual collisions
+    void call_handlers(entt::entity a, entt::entity b) const {
+        m_collisions.add();
+        const Callback::Registry& callbacks = Callback::Registry::get(*m_registry);
+        auto& handlers = m_registry->storage<Component::CollisionHandler>();
+        if (handlers.contains(a))
+            callbacks.call(handlers.get(a).callback, Entity(m_registry, a), Entity(m_registry, b));
+        if (handlers.contains(b))
+            callbacks.call(handlers.get(b).callback, Entity(m_registry, b), Entity(m_registry, a));
+    }
+
     static bool intersects(glm::vec4 a_lrbt, glm::vec4 b_lrbt) {
         bool x_overlap = (a_lrbt.x < b_lrbt.y) && (a_lrbt.y > b_lrbt.x);
         bool y_overlap = (a_lrbt.z < b_lrbt.w) && (a_lrbt.w > b_lrbt.z);
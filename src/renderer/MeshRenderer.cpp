@@ -1,4 +1,5 @@
 #include "MeshRenderer.hpp"
+#include "opengl/GLState.hpp"
 
 namespace Component {
     // TODO: check if move is the correct tool here
@@ -36,41 +37,75 @@ void MeshRenderer::init() {
     m_shadow_shader->add_source("../assets/shaders/3D/triangle.vert");
     m_shadow_shader->add_source("../assets/shaders/3D/shadow.frag");
     m_shadow_shader->compile();
+
+    m_state.set(*m_shader, [](GLShader& shader){
+        // TODO:
+        shader.set_uniform("light_direction", glm::normalize(glm::vec3(0.0f, -1.0f, 0.0)));
+        shader.set_uniform("light_color", glm::vec3(0.8f, 0.95f, 1.0f));
+        shader.set_uniform("ambient_color", glm::vec3(0.2f));
+    });
+    m_shadow_state.set(*m_shadow_shader);
+}
+
+void MeshRenderer::begin(RenderQueue& queue, const glm::mat4& projectionview, glm::vec3 eyeposition) {
+    m_queue = &queue;
+    m_eyeposition = eyeposition;
+    queue.set_uniforms(&m_state, [projectionview](GLShader& shader){
+        shader.set_uniform("projectionview", projectionview);
+    });
 }
 
-void MeshRenderer::begin(glm::mat4& projectionview) const {
-    m_shader->bind();
-    m_shader->set_uniform("projectionview", projectionview);
-    // TODO:
-    m_shader->set_uniform("light_direction", glm::normalize(glm::vec3(0.0f, -1.0f, 0.0)));
-    m_shader->set_uniform("light_color", glm::vec3(0.8f, 0.95f, 1.0f));
-    m_shader->set_uniform("ambient_color", glm::vec3(0.2f));
+void MeshRenderer::set_shadows(AbstractGLTexture& shadowmap, const glm::mat4& lightspace) {
+    AbstractGLTexture* texture = &shadowmap;
+    m_queue->set_uniforms(&m_state, [texture, lightspace](GLShader& shader){
+        shader.set_uniform("shadowmap", *texture);
+        shader.set_uniform("lightspace", lightspace);
+    });
 }
 
 void MeshRenderer::draw_mesh(Entity e) const {
     auto& mesh = e.get<Component::SimpleMesh>();
     auto& texture = e.get<Component::SimpleTexture2D>();
-    auto& transform = e.get<Component::Transform>();
-    m_shader->set_uniform("model", transform.get_matrix());
-    m_shader->set_uniform("normalmatrix", transform.get_normalmatrix());
-    m_shader->set_uniform("image", texture.texture);
-    mesh.va.bind();
-    glDrawElements(GL_TRIANGLES, mesh.va.index_count(), GL_UNSIGNED_INT, 0);
-}
+    auto& world = e.get<Component::WorldMatrix>();
 
-void MeshRenderer::end() const {
-    GLVertexArray::unbind();
+    // components may move in the registry before the queue executes, only
+    // GL handles go into the packet
+    uint32_t va = mesh.va.get_id();
+    uint32_t count = mesh.va.index_count();
+    glm::mat4 model = world.model;
+    glm::mat3 normal = world.normal;
+    float distance = glm::length(glm::vec3(model[3]) - m_eyeposition);
+
+    m_queue->submit(RenderQueue::GEOMETRY, &m_state, {"image", &texture.texture}, RenderQueue::depth_bits(distance), 
+        [va, count, model, normal](GLShader* shader){
+            shader->set_uniform("model", model);
+            shader->set_uniform("normalmatrix", normal);
+            GLState::get().bind_vertex_array(va);
+            glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
+        }
+    );
 }
 
-void MeshRenderer::begin_shadow(glm::mat4 &projectionview) const {
-    m_shadow_shader->bind();
-    m_shadow_shader->set_uniform("projectionview", projectionview);
+void MeshRenderer::begin_shadow(RenderQueue& queue, const glm::mat4& projectionview) {
+    m_queue = &queue;
+    queue.set_uniforms(&m_shadow_state, [projectionview](GLShader& shader){
+        shader.set_uniform("projectionview", projectionview);
+    });
 }
 
 void MeshRenderer::draw_shadow_mesh(Entity e) const {
     auto& mesh = e.get<Component::SimpleMesh>();
-    auto& transform = e.get<Component::Transform>();
-    m_shadow_shader->set_uniform("model", transform.get_matrix());
-    mesh.va.bind();
-    glDrawElements(GL_TRIANGLES, mesh.va.index_count(), GL_UNSIGNED_INT, 0);
+    auto& world = e.get<Component::WorldMatrix>();
+
+    uint32_t va = mesh.va.get_id();
+    uint32_t count = mesh.va.index_count();
+    glm::mat4 model = world.model;
+
+    m_queue->submit(RenderQueue::SHADOW, &m_shadow_state, 0, 
+        [va, count, model](GLShader* shader){
+            shader->set_uniform("model", model);
+            GLState::get().bind_vertex_array(va);
+            glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
+        }
+    );
 }
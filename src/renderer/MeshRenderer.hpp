@@ -6,6 +6,7 @@
 #include "opengl/GLTexture.hpp"
 #include "opengl/GLVertexArray.hpp"
 #include "opengl/GLShader.hpp"
+#include "RenderQueue.hpp"
 
 #include "Scene/Entity.hpp"
 
@@ -28,23 +29,29 @@ namespace Component {
 }
 
 // TODO: make a parent class for this
+// Records draws into a RenderQueue, meshes go to the GEOMETRY pass sorted
+// by texture and front to back, shadow meshes to the SHADOW pass.
 class MeshRenderer {
 private:
     std::shared_ptr<GLShader> m_shader = nullptr;
     std::shared_ptr<GLShader> m_shadow_shader = nullptr;
+    RenderQueue::ShaderState m_state;
+    RenderQueue::ShaderState m_shadow_state;
+
+    RenderQueue* m_queue = nullptr;
+    glm::vec3 m_eyeposition;
 
 public:
     MeshRenderer() = default;
     void init();
-    GLShader& get_shader() { return *m_shader; }
-
 
     // rendering
-    void begin(glm::mat4& projectionview) const;
+    void begin(RenderQueue& queue, const glm::mat4& projectionview, glm::vec3 eyeposition);
+    // after begin()
+    void set_shadows(AbstractGLTexture& shadowmap, const glm::mat4& lightspace);
     void draw_mesh(Entity e) const;
-    void end() const;
 
-    void begin_shadow(glm::mat4& projectionview) const;
+    void begin_shadow(RenderQueue& queue, const glm::mat4& projectionview);
     void draw_shadow_mesh(Entity e) const;
 
     // add cube components to existing entity
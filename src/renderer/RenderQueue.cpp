@@ -0,0 +1,160 @@
+#include "RenderQueue.hpp"
+
+#include <atomic>
+#include <iostream>
+
+// ShaderState
+
+static std::atomic<uint32_t> s_next_state_id{1};
+
+RenderQueue::ShaderState::ShaderState() {
+    uint32_t id = s_next_state_id.fetch_add(1, std::memory_order_relaxed);
+    if (id == 0x1000)
+        std::cout << "More than 4095 shader states, render queue keys will collide." << std::endl;
+    m_id = (uint16_t) id;
+}
+
+void RenderQueue::ShaderState::apply() const {
+    m_shader->bind();
+    if (m_setup)
+        m_setup(*m_shader);
+}
+
+// Bucket
+
+void* RenderQueue::Bucket::allocate(size_t bytes, size_t alignment) {
+    offset = (offset + alignment - 1) & ~(alignment - 1);
+    if (blocks.empty() || (offset + bytes > blocks[block].size)) {
+        if (!blocks.empty())
+            block++;
+        // large allocations get a block of their own size
+        const size_t size = std::max(BLOCK_SIZE, bytes);
+        if (block == blocks.size())
+            blocks.push_back({ std::unique_ptr<std::byte[]>(new std::byte[size]), size });
+        else if (blocks[block].size < size)
+            blocks[block] = { std::unique_ptr<std::byte[]>(new std::byte[size]), size };
+        offset = 0;
+    }
+    void* output = blocks[block].data.get() + offset;
+    offset += bytes;
+    return output;
+}
+
+void RenderQueue::Bucket::reset() {
+    packets.clear();
+    block = 0;
+    offset = 0;
+}
+
+// RenderQueue
+
+RenderQueue::RenderQueue() {
+    size_t count = JobSystem::get().thread_count() + 1;
+    for (Frame& frame : m_frames) {
+        for (size_t i = 0; i < count; i++)
+            frame.buckets.push_back(std::make_unique<Bucket>());
+        frame.buckets.back()->shared = true;
+    }
+}
+
+void RenderQueue::execute(uint32_t index) {
+    Metrics::Timer::Scope scope(m_execute_timer);
+    Frame& frame = m_frames[index];
+
+    m_packets.clear();
+    for (auto& bucket : frame.buckets)
+        m_packets.insert(m_packets.end(), bucket->packets.begin(), bucket->packets.end());
+    sort();
+    m_packet_count.add(m_packets.size());
+
+    size_t next_pass = 0;
+    const ShaderState* shader = nullptr;
+    Texture texture;
+    for (const Packet& packet : m_packets) {
+        size_t pass = (size_t) (packet.key >> 56);
+        if (pass >= next_pass) {
+            run_passes(frame, next_pass, pass + 1);
+            next_pass = pass + 1;
+            // pass setup may have changed anything
+            shader = nullptr;
+            texture = Texture();
+        }
+
+        if (packet.shader && (packet.shader != shader)) {
+            shader = packet.shader;
+            shader->apply();
+            for (const auto& [state, set_uniforms] : frame.uniforms)
+                if (state == shader)
+                    set_uniforms(shader->shader());
+            // texture slots belong to the program
+            texture = Texture();
+            m_shader_changes.add();
+        }
+        if (shader && packet.texture.id && (packet.texture != texture)) {
+            texture = packet.texture;
+            shader->shader()->set_texture(texture.name, texture.target, texture.id);
+            m_texture_changes.add();
+        }
+
+        packet.command(shader ? shader->shader() : nullptr);
+
+        // unknown state afterwards
+        if (!packet.shader) {
+            shader = nullptr;
+            texture = Texture();
+        }
+    }
+    run_passes(frame, next_pass, frame.passes.size());
+
+    // commands stay valid until here
+    for (auto& bucket : frame.buckets)
+        bucket->reset();
+    frame.passes.fill(Command());
+    frame.uniforms.clear();
+}
+
+void RenderQueue::run_passes(const Frame& frame, size_t first, size_t last) {
+    for (size_t pass = first; pass < last; pass++)
+        if (frame.passes[pass].function)
+            frame.passes[pass](nullptr);
+}
+
+// LSD radix sort on bytes, stable, so packets with equal keys stay in
+// recording order (per thread).
+void RenderQueue::sort() {
+    Metrics::Timer::Scope scope(m_sort_timer);
+    const size_t count = m_packets.size();
+    if (count < 2)
+        return;
+
+    // histograms of all 8 bytes in one pass
+    std::array<std::array<uint32_t, 256>, 8> histograms = {};
+    for (const Packet& packet : m_packets)
+        for (size_t b = 0; b < 8; b++)
+            histograms[b][(packet.key >> (8 * b)) & 0xFF]++;
+
+    m_scratch.resize(count);
+    Packet* input = m_packets.data();
+    Packet* output = m_scratch.data();
+    for (size_t b = 0; b < 8; b++) {
+        std::array<uint32_t, 256>& offsets = histograms[b];
+        const size_t shift = 8 * b;
+
+        // all keys share this byte (e.g. unused depth bits), nothing to do
+        if (offsets[(input[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        uint32_t sum = 0;
+        for (uint32_t& offset : offsets) {
+            uint32_t n = offset;
+            offset = sum;
+            sum += n;
+        }
+        for (size_t i = 0; i < count; i++)
+            output[offsets[(input[i].key >> shift) & 0xFF]++] = input[i];
+        std::swap(input, output);
+    }
+
+    if (input != m_packets.data())
+        m_packets.swap(m_scratch);
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "opengl/GLShader.hpp"
+#include "core/JobSystem.hpp"
+#include "core/Metrics.hpp"
+
+// Deferred draw calls. Renderers record draw packets during the frame, from
+// any thread, each with a 64 bit sort key
+//
+//     pass (8) | shader (12) | texture (12) | depth (32)
+//
+// execute() radix sorts all packets by key and runs them on the GL thread.
+// Passes run in order, within a pass draws are grouped by shader and texture
+// across renderers and the shader/texture state is only applied when it
+// changes from one packet to the next.
+//
+// Shaders come with a ShaderState owned by the renderer. Uniforms shared by
+// its draws (e.g. camera matrices) are recorded per frame with
+// set_uniforms(), passes are set up by the scene (framebuffer, viewport,
+// clears) with set_pass().
+//
+// The queue has two halves so the next frame can be recorded while the last
+// one executes on the render thread. close() ends recording of a frame,
+// execute(frame) runs it:
+//
+//     uint32_t frame = queue.close();
+//     RenderThread::get().run([&queue, frame](){ queue.execute(frame); });
+//
+//     queue.submit(RenderQueue::GEOMETRY, &m_state, {"image", &texture}, RenderQueue::depth_bits(distance),
+//         [va, model](GLShader* shader){ ... glDrawElements(...); }
+//     );
+class RenderQueue {
+public:
+    // Order of execution. What a pass does is up to set_pass().
+    enum Pass : uint8_t { SHADOW = 0, GEOMETRY = 1, SKY = 2, BLENDED = 3, OVERLAY = 4 };
+
+    // A shader program shared by the draws of a renderer. setup() runs with
+    // the program bound whenever a packet switches to this state, followed by
+    // the uniforms of set_uniforms(). It may only read data that doesn't
+    // change after init (e.g. lookup tables). Each state gets a unique id for
+    // the sort key.
+    class ShaderState {
+    private:
+        uint16_t m_id;
+        GLShader* m_shader = nullptr;
+        std::function<void(GLShader&)> m_setup;
+
+    public:
+        ShaderState();
+        ShaderState(const ShaderState&) = delete;
+        ShaderState& operator=(const ShaderState&) = delete;
+
+        void set(GLShader& shader, std::function<void(GLShader&)> setup = nullptr) {
+            m_shader = &shader;
+            m_setup = std::move(setup);
+        }
+
+        uint16_t id() const { return m_id; }
+        GLShader* shader() const { return m_shader; }
+        void apply() const;
+    };
+
+    // Texture bound to a sampler uniform of the packet's shader. Only the GL
+    // handle is kept, the texture object may move (e.g. in entt storage)
+    // before the queue executes.
+    struct Texture {
+        const char* name = nullptr;
+        GLenum target = 0;
+        uint32_t id = 0;
+
+        Texture() = default;
+        Texture(const char* name, const AbstractGLTexture* texture)
+            : name(name), target(texture ? texture->get_type() : 0), id(texture ? texture->get_id() : 0) {}
+
+        bool operator==(const Texture& other) const { return (name == other.name) && (target == other.target) && (id == other.id); }
+        bool operator!=(const Texture& other) const { return !(*this == other); }
+    };
+
+private:
+    using DrawFunction = void (*)(GLShader* shader, const void* command);
+
+    // A recorded function and its captures
+    struct Command {
+        DrawFunction function = nullptr;
+        const void* data = nullptr;
+
+        void operator()(GLShader* shader) const { function(shader, data); }
+    };
+
+    struct Packet {
+        uint64_t key;
+        const ShaderState* shader;
+        Texture texture;
+        Command command;
+    };
+
+    // Packets and commands recorded by one thread. Commands live in blocks
+    // which are kept between frames.
+    struct alignas(64) Bucket {
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        struct Block {
+            std::unique_ptr<std::byte[]> data;
+            size_t size;
+        };
+
+        std::vector<Packet> packets;
+        std::vector<Block> blocks;
+        size_t block = 0;
+        size_t offset = 0;
+        // only used for the shared bucket
+        std::mutex mutex;
+        bool shared = false;
+
+        void* allocate(size_t bytes, size_t alignment);
+        void reset();
+        std::unique_lock<std::mutex> lock() {
+            return shared ? std::unique_lock<std::mutex>(mutex) : std::unique_lock<std::mutex>();
+        }
+    };
+
+    // Everything recorded for one frame
+    struct Frame {
+        // one per job system thread + one shared by everyone else
+        std::vector<std::unique_ptr<Bucket>> buckets;
+        std::array<Command, 256> passes;
+        std::vector<std::pair<const ShaderState*, Command>> uniforms;
+    };
+
+    std::array<Frame, 2> m_frames;
+    uint32_t m_recording = 0;
+
+    // merged and sorted in execute()
+    std::vector<Packet> m_packets;
+    std::vector<Packet> m_scratch;
+
+    Metrics::Timer& m_sort_timer = Metrics::timer("RenderQueue/sort");
+    Metrics::Timer& m_execute_timer = Metrics::timer("RenderQueue/execute");
+    Metrics::Counter& m_packet_count = Metrics::counter("RenderQueue/packets");
+    Metrics::Counter& m_shader_changes = Metrics::counter("RenderQueue/shader changes");
+    Metrics::Counter& m_texture_changes = Metrics::counter("RenderQueue/texture changes");
+
+public:
+    RenderQueue();
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    // setup() runs at the start of `pass` when this frame executes, even if
+    // nothing was recorded for it. Like draws it gets copied into the queue,
+    // see submit(). Not thread safe, call from the recording thread.
+    template <typename F>
+    void set_pass(uint8_t pass, F&& setup) {
+        m_frames[m_recording].passes[pass] = record(
+            [setup = std::forward<F>(setup)](GLShader*){ setup(); }
+        );
+    }
+
+    // set_uniforms(GLShader& shader) runs after the ShaderState setup every
+    // time a packet switches to `state` this frame. Not thread safe, call
+    // from the recording thread.
+    template <typename F>
+    void set_uniforms(const ShaderState* state, F&& set_uniforms) {
+        m_frames[m_recording].uniforms.emplace_back(state, record(
+            [set_uniforms = std::forward<F>(set_uniforms)](GLShader* shader){ set_uniforms(*shader); }
+        ));
+    }
+
+    // Records a draw. draw(GLShader* shader) runs in execute() with the
+    // shader state and texture applied. It gets copied into the queue and
+    // is never destroyed, so capture pointers and values only. Whatever it
+    // points to has to stay valid and unchanged until the frame executed.
+    // Packets without shader state get nullptr and may change any GL state.
+    template <typename F>
+    void submit(uint8_t pass, const ShaderState* shader, Texture texture, uint32_t depth, F&& draw) {
+        Bucket& bucket = thread_bucket();
+        auto lock = bucket.lock();
+        bucket.packets.push_back({make_key(pass, shader, texture, depth), shader, texture, store(bucket, std::forward<F>(draw))});
+    }
+    template <typename F>
+    void submit(uint8_t pass, const ShaderState* shader, uint32_t depth, F&& draw) {
+        submit(pass, shader, Texture(), depth, std::forward<F>(draw));
+    }
+
+    // Memory that lives until the frame being recorded has executed, e.g.
+    // for data copied to the GPU by a draw. Thread safe.
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        Bucket& bucket = thread_bucket();
+        auto lock = bucket.lock();
+        return bucket.allocate(bytes, alignment);
+    }
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>, "Queue memory is never destroyed.");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Ends recording of the current frame and returns it for execute().
+    // Recording continues in the other half, which must have executed by
+    // now.
+    uint32_t close() {
+        uint32_t frame = m_recording;
+        m_recording ^= 1;
+        return frame;
+    }
+
+    // Sorts and runs a closed frame, then clears it. GL thread only.
+    void execute(uint32_t frame);
+
+    // Ids are only 12 bits in the key. Past 4096 shader states keys of
+    // different states can collide, which only affects grouping, not
+    // correctness.
+    static uint64_t make_key(uint8_t pass, const ShaderState* shader, const Texture& texture, uint32_t depth) {
+        uint64_t shader_bits = shader ? (shader->id() & 0xFFF) : 0;
+        uint64_t texture_bits = texture.id & 0xFFF;
+        return ((uint64_t) pass << 56) | (shader_bits << 44) | (texture_bits << 32) | depth;
+    }
+
+    // Sorts near to far for distances >= 0. Use ~depth_bits(distance) to go
+    // far to near, e.g. for blended geometry.
+    static uint32_t depth_bits(float distance) {
+        // positive floats order like their bit patterns
+        distance = std::max(distance, 0.0f);
+        uint32_t bits;
+        std::memcpy(&bits, &distance, sizeof(float));
+        return bits;
+    }
+
+private:
+    template <typename F>
+    static void call(GLShader* shader, const void* command) {
+        (*static_cast<const F*>(command))(shader);
+    }
+
+    // Copies a function into queue memory
+    template <typename F>
+    static Command store(Bucket& bucket, F&& function) {
+        using Function = std::decay_t<F>;
+        static_assert(std::is_trivially_destructible_v<Function>, "Draw commands should only capture pointers and values.");
+        static_assert(sizeof(Function) <= Bucket::BLOCK_SIZE, "Draw command too large.");
+        void* data = new (bucket.allocate(sizeof(Function), alignof(Function))) Function(std::forward<F>(function));
+        return { &call<Function>, data };
+    }
+    template <typename F>
+    Command record(F&& function) {
+        Bucket& bucket = thread_bucket();
+        auto lock = bucket.lock();
+        return store(bucket, std::forward<F>(function));
+    }
+
+    Bucket& thread_bucket() {
+        auto& buckets = m_frames[m_recording].buckets;
+        return *buckets[std::min(JobSystem::thread_index(), buckets.size() - 1)];
+    }
+
+    void run_passes(const Frame& frame, size_t first, size_t last);
+    void sort();
+};
@@ -1,131 +1,362 @@
-
 #include "Renderer2D.hpp"
 
+#include <algorithm>
+#include <cstring>
+
+#include "core/Metrics.hpp"
+
+static GLBufferLayout sprite_layout() {
+    return GLBufferLayout({
+        GLBufferElement("Position", GLType::Float2),
+        GLBufferElement("Size", GLType::Half2),
+        GLBufferElement("Color", GLType::UByte4, true),
+        GLBufferElement("Shape, Layer, Texture", GLType::UByte4),
+        GLBufferElement("UV", GLType::UShort4, true)
+    });
+}
+
 void Renderer2D::init() {
-    // Circle rendering
-    m_data.circle_vertex_buffer = std::make_shared<GLVertexBuffer>(
-        m_data.max_vertices * sizeof(CircleData), GL_STREAM_DRAW
-    );
-    m_data.circle_vertex_buffer->set_layout(GLBufferLayout({
-        GLBufferElement("Position", GLType::Float3),
-        GLBufferElement("Radius", GLType::Float),
-        GLBufferElement("Color", GLType::Float4)
-    }));
-
-    m_data.circle_vertex_array = std::make_shared<GLVertexArray>();
-    m_data.circle_vertex_array->push(m_data.circle_vertex_buffer);
-
-    m_data.circle_shader = std::make_shared<GLShader>();
-    m_data.circle_shader->add_source("../assets/shaders/2D/circle.vert");
-    m_data.circle_shader->add_source("../assets/shaders/2D/circle.geom");
-    m_data.circle_shader->add_source("../assets/shaders/2D/circle.frag");
-    m_data.circle_shader->compile();
-
-    m_data.circle_buffer = new CircleData[m_data.max_vertices];
-
-    // TODO: do this with a geometry shader?
-    // Quad rendering
-    m_data.quad_vertex_buffer = std::make_shared<GLVertexBuffer>(
-        m_data.max_vertices * sizeof(QuadVertex), GL_STREAM_DRAW
-    );
-    m_data.quad_vertex_buffer->set_layout(GLBufferLayout({
-        GLBufferElement("Position", GLType::Float3),
-        GLBufferElement("Size", GLType::Float2),
-        GLBufferElement("Color", GLType::Float4),
-    }));
-
-    m_data.quad_vertex_array = std::make_shared<GLVertexArray>();
-    m_data.quad_vertex_array->push(m_data.quad_vertex_buffer);
-    
-    // m_data_quad_shader = GLShader({"../shaders/quad.vert", "../shaders/quad.frag"});
-    m_data.quad_shader = std::make_shared<GLShader>();
-    m_data.quad_shader->add_source("../assets/shaders/2D/quad.vert");
-    m_data.quad_shader->add_source("../assets/shaders/2D/quad.geom");
-    m_data.quad_shader->add_source("../assets/shaders/2D/quad.frag");
-    m_data.quad_shader->compile();
-
-    m_data.quad_buffer = new QuadVertex[m_data.max_vertices];
+    // nothing per vertex, the corners come from gl_VertexID
+    m_data.sprite_buffer = std::make_shared<GLStreamBuffer>(m_data.max_frame_sprites * sizeof(SpriteInstance));
+    if (m_data.sprite_buffer->is_persistent()) {
+        m_data.sprite_buffer->set_layout(sprite_layout());
+        m_data.sprite_vertex_array = std::make_shared<GLVertexArray>();
+        m_data.sprite_vertex_array->push(m_data.sprite_buffer, 1);
+    } else {
+        m_data.sprite_buffer = nullptr;
+    }
+
+    m_data.copy_buffer = std::make_shared<GLStreamBuffer>(m_data.max_sprites * sizeof(SpriteInstance), GLStreamBuffer::ORPHANING);
+    m_data.copy_buffer->set_layout(sprite_layout());
+    m_data.copy_vertex_array = std::make_shared<GLVertexArray>();
+    m_data.copy_vertex_array->push(m_data.copy_buffer, 1);
+
+    m_data.sprite_shader = std::make_shared<GLShader>();
+    m_data.sprite_shader->add_source("../assets/shaders/2D/sprite.vert");
+    m_data.sprite_shader->add_source("../assets/shaders/2D/sprite.frag");
+    m_data.sprite_shader->compile();
+
+    m_data.textures = std::make_shared<GLTextureArray>();
+    m_data.textures->set_internal_format(GLTextureArray::RGBA8);
+    m_data.textures->allocate(m_data.texture_size, m_data.texture_size, m_data.max_textures);
+
+    m_data.sprites.reserve(m_data.max_sprites);
+    m_data.keys.reserve(m_data.max_sprites);
+
+    m_sprite_state.set(*m_data.sprite_shader);
 
     glEnable(GL_DEPTH_TEST);
+    // sprites are drawn in order within a layer, so later ones need to pass
+    glDepthFunc(GL_LEQUAL);
     glEnable(GL_BLEND);
     // glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); 
 }
 
-Renderer2D::~Renderer2D() {
-    delete m_data.circle_buffer;
-    delete m_data.quad_buffer;
-}
-
 // TODO: refactor this to work without glad
 #include <glad/gl.h>
 
-void Renderer2D::begin(glm::mat4& projectionview, glm::vec2 resolution) {
-    m_projectionview = projectionview;
-    m_resolution = resolution;
+void Renderer2D::begin(RenderQueue& queue, const glm::mat4& projectionview, glm::vec2 resolution) {
+    m_queue = &queue;
+    m_data.sprites.clear();
+    m_data.keys.clear();
+    m_data.last_key = 0;
+    m_data.sorted = true;
+    m_data.sequence = 0;
+
+    queue.set_uniforms(&m_sprite_state, [projectionview, resolution](GLShader& shader){
+        shader.set_uniform("projectionview", projectionview);
+        shader.set_uniform("resolution", resolution);
+    });
+}
+
+void Renderer2D::draw_quad(glm::vec2 position, glm::vec2 size, glm::vec4 color, int layer) {
+    draw_sprite(SpriteInstance(position, size, color, layer, QUAD));
+}
 
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+void Renderer2D::draw_circle(glm::vec2 position, float radius, glm::vec4 color, int layer) {
+    draw_sprite(SpriteInstance(position, glm::vec2(radius), color, layer, CIRCLE));
 }
 
-void Renderer2D::draw_quad(glm::vec3 pos, glm::vec2 size, glm::vec4 color) {
-    if (m_data.quad_index == m_data.max_vertices)
-        render_quads();
+void Renderer2D::draw_quad(const Component::Transform2D& transform, glm::vec4 color, int layer) {
+    draw_sprite(SpriteInstance::quad(transform, color, layer));
+}
 
-    m_data.quad_buffer[m_data.quad_index] = QuadVertex(pos, size, color);
-        
-    m_data.quad_index = m_data.quad_index + 1;
+void Renderer2D::draw_quad(const Component::Transform2D& transform, const Component::Quad& quad, int layer) {
+    draw_sprite(SpriteInstance::quad(transform, quad, layer));
 }
 
-void Renderer2D::draw_circle(glm::vec3 position, float radius, glm::vec4 color) {
-    if (m_data.circle_index == m_data.max_vertices)
-        render_circles();
+void Renderer2D::draw_circle(const Component::Transform2D& transform, glm::vec4 color, int layer) {
+    draw_sprite(SpriteInstance::circle(transform, color, layer));
+}
 
-    m_data.circle_buffer[m_data.circle_index] = CircleData(position, radius, color);
+void Renderer2D::draw_sprite(const SpriteInstance& sprite) {
+    // The shape is the material for now, textures etc should go there too
+    uint32_t key = ((uint32_t) sprite.layer_bits << 8) | (uint32_t) sprite.shape;
+    m_data.sorted = m_data.sorted && (key >= m_data.last_key);
+    m_data.last_key = key;
 
-    m_data.circle_index = m_data.circle_index + 1;
+    m_data.keys.push_back(((uint64_t) key << 32) | m_data.sprites.size());
+    m_data.sprites.push_back(sprite);
 }
 
 void Renderer2D::end() {
-    // TODO: swap buffers here?
-    // probably not because we might have multiple renderers in the future?
-    
-    // flush buffers
-    render_quads();
-    render_circles();
+    record_static();
+    record_batches();
+    record_sprites();
+
+    // fences the section the sprite draws above read from
+    if (m_data.sprite_buffer) {
+        GLStreamBuffer* buffer = m_data.sprite_buffer.get();
+        uint32_t section = buffer->close_frame();
+        m_queue->submit(RenderQueue::BLENDED, &m_sprite_state, sprite_textures(), UINT32_MAX, 
+            [buffer, section](GLShader*){ buffer->end_frame(section); }
+        );
+    }
+}
+
+// Bulk submission
+
+Renderer2D::SpriteInstance* Renderer2D::map_batch(size_t count, int layer) {
+    Renderer2DData::Batch& batch = m_data.batch;
+    batch.count = std::min(count, max_batch_size());
+    batch.layer_bits = (uint8_t) (std::clamp(layer, -127, 127) + 128);
+    batch.sprites = allocate_sprites(batch.count, batch.offset);
+    return batch.sprites;
 }
 
-void Renderer2D::render_circles() {
-    if (m_data.circle_index == 0)
+void Renderer2D::submit_batch(size_t circles) {
+    if (m_data.batch.count == 0)
         return;
+    m_circles_drawn.add(circles);
+    m_quads_drawn.add(m_data.batch.count - circles);
+    m_data.batches.push_back(m_data.batch);
+    m_data.batch = Renderer2DData::Batch();
+}
+
+void Renderer2D::record_batches() {
+    for (const Renderer2DData::Batch& batch : m_data.batches)
+        submit_sprites(batch.sprites, batch.offset, batch.count, draw_order(batch.layer_bits, m_data.sequence++));
+    m_data.batches.clear();
+}
 
-    m_data.circle_vertex_array->bind();
-    m_data.circle_vertex_buffer->set_data(m_data.circle_buffer, m_data.circle_index * sizeof(CircleData));
-    
-    m_data.circle_shader->use();
-    m_data.circle_shader->set_uniform("projectionview", m_projectionview);
-    // m_data.circle_shader->set_uniform("projection", m_camera.m_projection);
-    // m_data.circle_shader->set_uniform("view", m_camera.m_view);
-    m_data.circle_shader->set_uniform("resolution", m_resolution);
+Renderer2D::SpriteInstance* Renderer2D::allocate_sprites(size_t n, size_t& offset) {
+    if (m_data.sprite_buffer) {
+        void* mapped = m_data.sprite_buffer->allocate(n * sizeof(SpriteInstance), offset);
+        if (mapped)
+            return static_cast<SpriteInstance*>(mapped);
+    }
+    offset = SIZE_MAX;
+    return m_queue->allocate<SpriteInstance>(n);
+}
+
+void Renderer2D::submit_sprites(const SpriteInstance* sprites, size_t offset, size_t n, uint32_t depth) {
+    if (offset != SIZE_MAX) {
+        m_queue->submit(RenderQueue::BLENDED, &m_sprite_state, sprite_textures(), depth, 
+            [this, offset, n](GLShader*){ draw_mapped(offset, n); }
+        );
+    } else {
+        m_queue->submit(RenderQueue::BLENDED, &m_sprite_state, sprite_textures(), depth, 
+            [this, sprites, n](GLShader*){ draw_copied(sprites, n); }
+        );
+    }
+}
 
-    glDrawArrays(GL_POINTS, 0, m_data.circle_index);
+// Retained sprites
 
-    m_data.circle_index = 0;
+uint32_t Renderer2D::add_static(const SpriteInstance& sprite) {
+    RetainedSprites& retained = m_static[sprite.layer_bits];
+    uint32_t slot;
+    if (retained.free_slots.empty()) {
+        slot = (uint32_t) retained.sprites.size();
+        retained.sprites.push_back(sprite);
+    } else {
+        slot = retained.free_slots.back();
+        retained.free_slots.pop_back();
+        retained.sprites[slot] = sprite;
+    }
+    retained.mark_dirty(slot);
+    return ((uint32_t) sprite.layer_bits << 24) | slot;
 }
 
-void Renderer2D::render_quads() {
-    if (m_data.quad_index == 0)
+uint32_t Renderer2D::update_static(uint32_t handle, const SpriteInstance& sprite) {
+    if ((handle >> 24) != sprite.layer_bits) {
+        remove_static(handle);
+        return add_static(sprite);
+    }
+    RetainedSprites& retained = m_static[handle >> 24];
+    const uint32_t slot = handle & 0xFFFFFF;
+    retained.sprites[slot] = sprite;
+    retained.mark_dirty(slot);
+    return handle;
+}
+
+void Renderer2D::remove_static(uint32_t handle) {
+    RetainedSprites& retained = m_static[handle >> 24];
+    const uint32_t slot = handle & 0xFFFFFF;
+    // zero sized sprites don't produce fragments
+    retained.sprites[slot].size = Half2(glm::vec2(0.0f));
+    retained.free_slots.push_back(slot);
+    retained.mark_dirty(slot);
+}
+
+void Renderer2D::clear_static() {
+    for (RetainedSprites& retained : m_static) {
+        retained.sprites.clear();
+        retained.free_slots.clear();
+        retained.dirty_begin = SIZE_MAX;
+        retained.dirty_end = 0;
+    }
+}
+
+// Textures
+
+Component::SpriteTexture Renderer2D::load_texture(const std::string& filepath) {
+    Component::SpriteTexture output;
+    if (m_data.texture_count == m_data.max_textures) {
+        std::cout << "No more sprite texture layers available for " << filepath << std::endl;
+        return output;
+    }
+
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* data = stbi_load(filepath.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        std::cout << "Failed to load " << filepath << std::endl;
+        return output;
+    }
+    if ((width > (int) m_data.texture_size) || (height > (int) m_data.texture_size)) {
+        std::cout << filepath << " is larger than " << m_data.texture_size << "x" << m_data.texture_size << std::endl;
+        stbi_image_free(data);
+        return output;
+    }
+
+    m_data.textures->set_layer(m_data.texture_count, data, GLTextureArray::RGBA, width, height);
+    stbi_image_free(data);
+
+    // the image sits in the bottom left corner of the layer
+    m_data.texture_count++;
+    output.layer = (uint8_t) m_data.texture_count;
+    output.uv = glm::vec4(0.0f, 0.0f, (float) width / m_data.texture_size, (float) height / m_data.texture_size);
+    return output;
+}
+
+void Renderer2D::record_static() {
+    size_t alive = 0;
+    // one draw per layer, each goes first within its layer
+    for (size_t layer_bits = 0; layer_bits < m_static.size(); layer_bits++) {
+        RetainedSprites& retained = m_static[layer_bits];
+        alive += retained.sprites.size() - retained.free_slots.size();
+        if (retained.sprites.empty())
+            continue;
+
+        if (retained.sprites.size() > retained.capacity) {
+            // grow, this needs a full upload
+            retained.capacity = std::max<size_t>(1024, 2 * retained.sprites.size());
+            retained.dirty_begin = 0;
+            retained.dirty_end = retained.sprites.size();
+        }
+
+        // the changed range is copied, the GL thread uploads it before drawing
+        const SpriteInstance* upload = nullptr;
+        const size_t begin = retained.dirty_begin, end = retained.dirty_end;
+        if (begin < end) {
+            SpriteInstance* copy = m_queue->allocate<SpriteInstance>(end - begin);
+            std::memcpy(copy, retained.sprites.data() + begin, (end - begin) * sizeof(SpriteInstance));
+            upload = copy;
+            m_static_uploaded.add((end - begin) * sizeof(SpriteInstance));
+            retained.dirty_begin = SIZE_MAX;
+            retained.dirty_end = 0;
+        }
+
+        // the GL side of `retained` is only touched by the GL thread
+        RetainedSprites* gpu = &retained;
+        const size_t count = retained.sprites.size(), capacity = retained.capacity;
+        m_queue->submit(RenderQueue::BLENDED, &m_sprite_state, sprite_textures(), draw_order((uint8_t) layer_bits, m_data.sequence++), 
+            [this, gpu, count, capacity, upload, begin, end](GLShader*){ draw_static(*gpu, count, capacity, upload, begin, end); }
+        );
+    }
+    m_static_count.set((double) alive);
+}
+
+void Renderer2D::draw_static(RetainedSprites& retained, size_t count, size_t capacity, const SpriteInstance* upload, size_t begin, size_t end) {
+    if (!retained.buffer || (retained.buffer->bytesize() < capacity * sizeof(SpriteInstance))) {
+        retained.buffer = std::make_shared<GLVertexBuffer>(capacity * sizeof(SpriteInstance), GLBuffer::DYNAMIC_DRAW);
+        retained.buffer->set_layout(sprite_layout());
+        retained.vertex_array = std::make_shared<GLVertexArray>();
+        retained.vertex_array->push(retained.buffer, 1);
+    }
+    if (upload)
+        retained.buffer->set_data(upload, begin * sizeof(SpriteInstance), (end - begin) * sizeof(SpriteInstance));
+
+    retained.vertex_array->bind();
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) count);
+    m_draw_calls.add();
+}
+
+void Renderer2D::record_sprites() {
+    const size_t count = m_data.sprites.size();
+    if (count == 0)
         return;
 
-    m_data.quad_vertex_array->bind();
-    m_data.quad_vertex_buffer->set_data(m_data.quad_buffer, m_data.quad_index * sizeof(QuadVertex));
+    if (!m_data.sorted) {
+        std::sort(m_data.keys.begin(), m_data.keys.end());
+        m_sorts.add();
+    }
 
-    m_data.quad_shader->use();
-    m_data.circle_shader->set_uniform("projectionview", m_projectionview);
-    // m_data.quad_shader->set_uniform("projection", m_camera.m_projection);
-    // m_data.quad_shader->set_uniform("view", m_camera.m_view);
+    // Everything is the same draw state, so this only splits per layer (so
+    // static sprites and batches can go in between) and when a batch doesn't
+    // fit the stream buffer anymore. Sprites are copied out in draw order,
+    // m_data is reused for the next frame before this one is drawn.
+    auto layer_bits = [this](size_t i){ return (uint8_t) (m_data.keys[i] >> 40); };
+    for (size_t first = 0, n = 0; first < count; first += n) {
+        const uint8_t layer = layer_bits(first);
+        const size_t last = std::min<size_t>(first + m_data.max_sprites, count);
+        n = 1;
+        while ((first + n < last) && (layer_bits(first + n) == layer))
+            n++;
 
-    glDrawArrays(GL_POINTS, 0, m_data.quad_index);
+        size_t offset;
+        SpriteInstance* sprites = allocate_sprites(n, offset);
+        uint64_t circles = 0;
+        if (m_data.sorted) {
+            std::memcpy(sprites, m_data.sprites.data() + first, n * sizeof(SpriteInstance));
+            for (size_t i = first; i < first + n; i++)
+                circles += m_data.sprites[i].shape == CIRCLE;
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                const SpriteInstance& sprite = m_data.sprites[(uint32_t) m_data.keys[first + i]];
+                sprites[i] = sprite;
+                circles += sprite.shape == CIRCLE;
+            }
+        }
+        m_circles_drawn.add(circles);
+        m_quads_drawn.add(n - circles);
 
-    m_data.quad_index = 0;
-}
\ No newline at end of file
+        submit_sprites(sprites, offset, n, draw_order(layer, m_data.sequence++));
+    }
+}
+
+void Renderer2D::draw_mapped(size_t offset, size_t n) {
+    draw_instances(*m_data.sprite_vertex_array, offset, n);
+}
+
+void Renderer2D::draw_copied(const SpriteInstance* sprites, size_t n) {
+    // the copy buffer orphans when full, so this draws before the next reserve()
+    void* output = m_data.copy_buffer->reserve(n * sizeof(SpriteInstance));
+    {
+        Metrics::Timer::Scope scope(m_stream_copy_time);
+        std::memcpy(output, sprites, n * sizeof(SpriteInstance));
+    }
+    m_stream_copied.add(n * sizeof(SpriteInstance));
+    size_t offset = m_data.copy_buffer->commit(n * sizeof(SpriteInstance));
+    draw_instances(*m_data.copy_vertex_array, offset, n);
+}
+
+void Renderer2D::draw_instances(GLVertexArray& vertex_array, size_t offset, size_t n) {
+    vertex_array.bind();
+    vertex_array.set_offset(0, offset);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) n);
+    m_draw_calls.add();
+    m_sprites_drawn.add(n);
+}
@@ -1,83 +1,230 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
 #include "opengl/GLShader.hpp"
+#include "opengl/GLPackedTypes.hpp"
 #include "opengl/GLVertexArray.hpp"
+#include "opengl/GLStreamBuffer.hpp"
+#include "core/Metrics.hpp"
+#include "Scene/Components.hpp"
+#include "RenderQueue.hpp"
 
 // TODO: make these class constants?
-#define RENDERER2D_MAX_QUADS 20000
-#define RENDERER2D_MAX_VERTICES RENDERER2D_MAX_QUADS * 4 
-#define RENDERER2D_MAX_INDICES RENDERER2D_MAX_QUADS * 6
-
+#define RENDERER2D_MAX_SPRITES 65536
+// size and number of layers of the sprite texture array
+#define RENDERER2D_TEXTURE_SIZE 256
+#define RENDERER2D_MAX_TEXTURES 64
+
+// Quads and circles are both sprites, i.e. instances of one shader drawing a
+// triangle strip per instance. Draws are collected until end(), sorted by
+// layer and material and then submitted in as few draw calls as possible.
+// Higher layers are drawn later and on top, the layer is the top of the
+// depth bits of every packet.
+// Sprites that rarely change can be retained instead (add_static), those
+// stay on the GPU and are drawn first within their layer every frame. Large
+// numbers of sprites can also be written straight into the stream buffer
+// (map_batch), e.g. by worker threads.
+// Textures are layers of one texture array, so textured sprites don't break
+// batches either. Each sprite picks a layer and a uv rect from it.
+// begin() to end() only records into a RenderQueue (BLENDED pass) and makes
+// no GL calls. Sprites go into the persistently mapped section of the frame,
+// the GL thread only draws them when the queue executes. Without GL 4.4, or
+// once a frame has more than max_frame_sprites, sprites go into queue memory
+// instead and the GL thread copies them into an orphaned buffer ("stream
+// buffer copy" metrics).
 class Renderer2D {
-private:
-    struct QuadVertex {
-        glm::vec3 position;
-        glm::vec2 size;
-        glm::vec4 color;
-
-        QuadVertex() = default;
-        QuadVertex(glm::vec3 p, glm::vec2 s, glm::vec4 c) 
-            : position(p), size(s), color(c) {}
-    };
-
-    struct CircleData {
-        glm::vec3 position;
-        float radius;
-        glm::vec4 color;
-
-        CircleData() = default;
-        CircleData(glm::vec3& pos, float r, glm::vec4 c)
-            : position(pos), radius(r), color(c) {}
+public:
+    enum Shape : int32_t { QUAD = 0, CIRCLE = 1 };
+
+    // Per instance data, see assets/shaders/2D/sprite.vert. Positions stay
+    // 32 bit floats, half floats lose too much far from the origin (steps
+    // of 1/16 at 100). Sizes are half floats, about 1/1000 precise relative
+    // to the size.
+    struct SpriteInstance {
+        glm::vec2 position; // bottom left for quads, center for circles
+        Half2 size;         // circles use size.x as the radius
+        RGBA8 color;
+        uint8_t shape;
+        // layer + 128
+        uint8_t layer_bits;
+        // texture array layer + 1, 0 is untextured
+        uint8_t texture = 0;
+        uint8_t padding = 0;
+        UNorm16x4 uv = UNorm16x4(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+
+        SpriteInstance() = default;
+        // layers range from -127 to 127
+        SpriteInstance(glm::vec2 p, glm::vec2 s, glm::vec4 c, int layer, Shape shape)
+            : position(p), size(s), color(c), shape((uint8_t) shape), 
+            layer_bits((uint8_t) (std::clamp(layer, -127, 127) + 128)) {}
+        SpriteInstance(glm::vec2 p, glm::vec2 s, glm::vec4 c, int layer, Shape shape, const Component::SpriteTexture& tex)
+            : SpriteInstance(p, s, c, layer, shape) 
+        {
+            texture = tex.layer;
+            uv = tex.uv;
+        }
+
+        // scale is the size of the quad, scale.x the circle radius
+        static SpriteInstance quad(const Component::Transform2D& transform, glm::vec4 color, int layer = 0) {
+            return SpriteInstance(transform.position, transform.scale, color, layer, QUAD);
+        }
+        static SpriteInstance quad(const Component::Transform2D& transform, const Component::Quad& quad, int layer = 0) {
+            return SpriteInstance(transform.position, transform.scale, quad.color, layer, QUAD, quad.texture);
+        }
+        static SpriteInstance circle(const Component::Transform2D& transform, glm::vec4 color, int layer = 0) {
+            return SpriteInstance(transform.position, glm::vec2(transform.scale.x), color, layer, CIRCLE);
+        }
+
+        int layer() const { return (int) layer_bits - 128; }
     };
+    static_assert(sizeof(SpriteInstance) == 28, "SpriteInstance should be tightly packed.");
 
+private:
     struct Renderer2DData {
         // constants
-        static const unsigned int max_quads = RENDERER2D_MAX_QUADS;
-        static const unsigned int max_vertices = RENDERER2D_MAX_VERTICES;
-        static const unsigned int max_indices = RENDERER2D_MAX_INDICES;
-
-        // render data
-        std::shared_ptr<GLVertexBuffer> quad_vertex_buffer;
-        std::shared_ptr<GLVertexArray>  quad_vertex_array;
-        std::shared_ptr<GLShader>       quad_shader;
-
-        std::shared_ptr<GLVertexBuffer> circle_vertex_buffer;
-        std::shared_ptr<GLVertexArray>  circle_vertex_array;
-        std::shared_ptr<GLShader>       circle_shader;
-
-        // object related
-        // maybe pointers to last added?
-        unsigned int quad_count = 0;
-        unsigned int quad_index = 0;
-        QuadVertex* quad_buffer = nullptr;
-        // QuadVertex quad_buffer[RENDERER2D_MAX_VERTICES]; // No?
-
-        unsigned int circle_count = 0;
-        unsigned int circle_index = 0;
-        CircleData* circle_buffer = nullptr;
-        // CircleData circle_buffer[RENDERER2D_MAX_VERTICES];
+        static const unsigned int max_sprites = RENDERER2D_MAX_SPRITES;
+        // mapped sprites per frame, i.e. the stream buffer section size
+        static const unsigned int max_frame_sprites = 4 * max_sprites;
+
+        // render data, sprite_buffer is null without persistent mapping
+        std::shared_ptr<GLStreamBuffer> sprite_buffer;
+        std::shared_ptr<GLVertexArray>  sprite_vertex_array;
+        std::shared_ptr<GLStreamBuffer> copy_buffer;
+        std::shared_ptr<GLVertexArray>  copy_vertex_array;
+        std::shared_ptr<GLShader>       sprite_shader;
+
+        // textures
+        static const unsigned int texture_size = RENDERER2D_TEXTURE_SIZE;
+        static const unsigned int max_textures = RENDERER2D_MAX_TEXTURES;
+        std::shared_ptr<GLTextureArray> textures;
+        unsigned int texture_count = 0;
+
+        // collected between begin() and end()
+        std::vector<SpriteInstance> sprites;
+        // sort key << 32 | submission index, so sorting is stable
+        std::vector<uint64_t> keys;
+        uint32_t last_key = 0;
+        // submitted in key order, no need to sort
+        bool sorted = true;
+
+        // order of draws within the frame, goes into the depth bits
+        uint32_t sequence = 0;
+
+        // mapped but not yet submitted batch
+        struct Batch {
+            SpriteInstance* sprites = nullptr;
+            // in the stream buffer, SIZE_MAX for queue memory
+            size_t offset = SIZE_MAX;
+            size_t count = 0;
+            uint8_t layer_bits = 128;
+        };
+        Batch batch;
+        std::vector<Batch> batches;
+    };
+
+    // Retained sprites of one layer, see add_static()
+    struct RetainedSprites {
+        // only touched when the queue executes
+        std::shared_ptr<GLVertexBuffer> buffer;
+        std::shared_ptr<GLVertexArray>  vertex_array;
+        // GPU capacity in sprites, decided when recording
+        size_t capacity = 0;
+
+        // copy of the GPU data, removed sprites are zero sized until reused
+        std::vector<SpriteInstance> sprites;
+        std::vector<uint32_t> free_slots;
+        // sprites changed since the last upload
+        size_t dirty_begin = SIZE_MAX;
+        size_t dirty_end = 0;
+
+        void mark_dirty(size_t idx) {
+            dirty_begin = std::min(dirty_begin, idx);
+            dirty_end = std::max(dirty_end, idx + 1);
+        }
     };
     
     Renderer2DData m_data;
-    glm::mat4 m_projectionview;
-    glm::vec2 m_resolution;
+    // by layer_bits, static handles are layer_bits << 24 | slot
+    std::array<RetainedSprites, 256> m_static;
+    RenderQueue::ShaderState m_sprite_state;
+    RenderQueue* m_queue = nullptr;
+
+    Metrics::Counter& m_draw_calls = Metrics::counter("Renderer2D/draw calls");
+    Metrics::Counter& m_sprites_drawn = Metrics::counter("Renderer2D/sprites");
+    Metrics::Counter& m_quads_drawn = Metrics::counter("Renderer2D/quads");
+    Metrics::Counter& m_circles_drawn = Metrics::counter("Renderer2D/circles");
+    Metrics::Counter& m_sorts = Metrics::counter("Renderer2D/sorts");
+    Metrics::Counter& m_static_uploaded = Metrics::counter("Renderer2D/static bytes uploaded");
+    Metrics::Counter& m_stream_copied = Metrics::counter("Renderer2D/stream buffer copy bytes");
+    Metrics::Timer& m_stream_copy_time = Metrics::timer("Renderer2D/stream buffer copy");
+    Metrics::Gauge& m_static_count = Metrics::gauge("Renderer2D/static sprites");
     
 public:
     Renderer2D() = default;
-    ~Renderer2D();
 
     void init();
 
-    void begin(glm::mat4& projectionview, glm::vec2 resolution);
-    void draw_quad(glm::vec3 position, glm::vec2 size, glm::vec4 color);
-    void draw_circle(glm::vec3 position, float radius, glm::vec4 color);
+    // Starts recording into `queue`
+    void begin(RenderQueue& queue, const glm::mat4& projectionview, glm::vec2 resolution);
+    // layers range from -127 to 127
+    void draw_quad(glm::vec2 position, glm::vec2 size, glm::vec4 color, int layer = 0);
+    void draw_circle(glm::vec2 position, float radius, glm::vec4 color, int layer = 0);
+    // scale is the size of the quad, scale.x the circle radius
+    void draw_quad(const Component::Transform2D& transform, glm::vec4 color, int layer = 0);
+    void draw_quad(const Component::Transform2D& transform, const Component::Quad& quad, int layer = 0);
+    void draw_circle(const Component::Transform2D& transform, glm::vec4 color, int layer = 0);
+    void draw_sprite(const SpriteInstance& sprite);
+    // Records everything drawn since begin() into the queue
     void end();
 
+    // Bulk submission. Returns memory for `count` sprites (at most
+    // max_batch_size()), which may be filled from any thread. It's usually
+    // mapped, i.e. write only. Call submit_batch() once all of it is written
+    // and before mapping the next batch, with the number of circles in it
+    // for the metrics. A batch is drawn as a whole at `layer`, after the
+    // static sprites and before the draw_*() sprites of that layer, so its
+    // sprites should all be on it. Needs begin() first.
+    SpriteInstance* map_batch(size_t count, int layer = 0);
+    void submit_batch(size_t circles);
+    static constexpr size_t max_batch_size() { return RENDERER2D_MAX_SPRITES; }
+
+    // Retained sprites, e.g. for level geometry. These are drawn every frame
+    // until removed. Changes are recorded in end() and uploaded when the
+    // queue executes, and only the range of sprites that changed. Returns a
+    // handle for updating/removing it. The handle changes when an update
+    // moves the sprite to another layer.
+    uint32_t add_static(const SpriteInstance& sprite);
+    uint32_t update_static(uint32_t handle, const SpriteInstance& sprite);
+    void remove_static(uint32_t handle);
+    void clear_static();
+
+    // Loads an image into the next layer of the texture array. Images can be
+    // at most RENDERER2D_TEXTURE_SIZE pixels wide and high, atlases work too
+    // (see SpriteTexture::region). Returns an untextured SpriteTexture if
+    // the image can't be loaded. Needs init() first and the GL context, i.e.
+    // call it before the render thread starts (see RenderThread).
+    Component::SpriteTexture load_texture(const std::string& filepath);
+
 private:
-    void render_circles();
-    void render_quads();
-};
\ No newline at end of file
+    void record_static();
+    void record_batches();
+    void record_sprites();
+    // Stream buffer memory for n sprites of this frame (sets offset), or
+    // queue memory (offset = SIZE_MAX) once the frame's section is full
+    SpriteInstance* allocate_sprites(size_t n, size_t& offset);
+    void submit_sprites(const SpriteInstance* sprites, size_t offset, size_t n, uint32_t depth);
+    // depth bits of a packet, draws are ordered by layer first
+    static uint32_t draw_order(uint8_t layer_bits, uint32_t sequence) { return ((uint32_t) layer_bits << 24) | sequence; }
+    // GL thread
+    void draw_static(RetainedSprites& retained, size_t count, size_t capacity, const SpriteInstance* upload, size_t begin, size_t end);
+    void draw_mapped(size_t offset, size_t count);
+    void draw_copied(const SpriteInstance* sprites, size_t count);
+    void draw_instances(const GLVertexArray& vertex_array, size_t offset, size_t count);
+    RenderQueue::Texture sprite_textures() const { return { "sprite_textures", m_data.textures.get() }; }
+};
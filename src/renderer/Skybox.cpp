@@ -66,15 +66,22 @@ SkyBox::SkyBox(std::array<std::string, 6> filepaths) {
     shader.add_source("../assets/shaders/3D/skybox.vert");
     shader.add_source("../assets/shaders/3D/skybox.frag");
     shader.compile();
+
+    m_state.set(shader);
 }
 
-void SkyBox::render(glm::mat4& view, glm::mat4& projection){
-    glDepthFunc(GL_LEQUAL); 
-    shader.bind();
-    va.bind();
-    cubemap.bind(); // TODO: maybe switch to using shader.set_uniform(name, cubemap)
-    shader.set_uniform("view", glm::mat4(glm::mat3(view)));
-    shader.set_uniform("projection", projection);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glDepthFunc(GL_LESS); 
+void SkyBox::render(RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection){
+    glm::mat4 rotation = glm::mat4(glm::mat3(view));
+    queue.set_uniforms(&m_state, [rotation, projection](GLShader& shader){
+        shader.set_uniform("view", rotation);
+        shader.set_uniform("projection", projection);
+    });
+
+    const GLVertexArray* vertex_array = &va;
+    queue.submit(RenderQueue::SKY, &m_state, {"cubemap", &cubemap}, 0, [vertex_array](GLShader*){
+        glDepthFunc(GL_LEQUAL); 
+        vertex_array->bind();
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glDepthFunc(GL_LESS); 
+    });
 }
\ No newline at end of file
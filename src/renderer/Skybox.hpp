@@ -5,17 +5,21 @@
 #include "opengl/GLTexture.hpp"
 #include "opengl/GLVertexArray.hpp"
 #include "opengl/GLShader.hpp"
+#include "RenderQueue.hpp"
 
 // TODO: rework to use ECS
 // TODO: rework to fit a general interface
 
+// Drawn in the SKY pass, i.e. after opaque geometry so only uncovered
+// pixels are shaded
 class SkyBox {
 private:
     GLVertexArray va;
     GLShader shader;
     GLCubeMap cubemap;
+    RenderQueue::ShaderState m_state;
 
 public:
     SkyBox(std::array<std::string, 6> filepaths);
-    void render(glm::mat4& view, glm::mat4& projection);
+    void render(RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection);
 };
\ No newline at end of file
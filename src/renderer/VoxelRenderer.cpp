@@ -1,5 +1,7 @@
 #include "VoxelRenderer.hpp"
 
+#include <cstring>
+
 void VoxelRenderer::init() {
     // TODO: reorganize rendering to centered between voxels:
     // --x---+---x---+--
@@ -71,54 +73,89 @@ void VoxelRenderer::init() {
     render_data.texture_map->set_mag_filter(GLTexture::NEAREST);
     render_data.texture_map->load("../assets/texture_map.png");
     render_data.texture_map->set_element_pixel_size(16, 16);
-}
-
-void VoxelRenderer::begin(glm::mat4& projectionview) const {
-    render_data.shader->bind();
-    render_data.va->bind();
-
-    render_data.shader->set_uniform("block_id", *render_data.block_id);
 
-    render_data.uv_idx_map->bind();
-    render_data.shader->set_uniform_block("uv_lut_block", 0);
-    render_data.uv_idx_map->bind_buffer_base(0);
-
-    render_data.shader->set_uniform("texture_map", *render_data.texture_map);
-    render_data.shader->set_uniform("tex_uv_size", render_data.texture_map->get_uv_size());
-    render_data.shader->set_uniform("tex_index_size", render_data.texture_map->get_index_size());
+    m_state.set(*render_data.shader, [this](GLShader& shader){
+        shader.set_uniform("block_id", *render_data.block_id);
+
+        render_data.uv_idx_map->bind();
+        shader.set_uniform_block("uv_lut_block", 0);
+        render_data.uv_idx_map->bind_buffer_base(0);
+
+        shader.set_uniform("texture_map", *render_data.texture_map);
+        shader.set_uniform("tex_uv_size", render_data.texture_map->get_uv_size());
+        shader.set_uniform("tex_index_size", render_data.texture_map->get_index_size());
+
+        // TODO:
+        shader.set_uniform("light_direction", glm::normalize(glm::vec3(0.0f, -1.0f, 0.0)));
+        shader.set_uniform("light_color", glm::vec3(0.8f, 0.95f, 1.0f));
+        shader.set_uniform("ambient_color", glm::vec3(0.2f));
+    });
+    m_shadow_state.set(*render_data.shadow_shader, [this](GLShader& shader){
+        shader.set_uniform("block_id", *render_data.block_id);
+    });
+}
 
-    render_data.shader->set_uniform("projectionview", projectionview);
-    // TODO:
-    render_data.shader->set_uniform("light_direction", glm::normalize(glm::vec3(0.0f, -1.0f, 0.0)));
-    render_data.shader->set_uniform("light_color", glm::vec3(0.8f, 0.95f, 1.0f));
-    render_data.shader->set_uniform("ambient_color", glm::vec3(0.2f));
+void VoxelRenderer::begin(RenderQueue& queue, const glm::mat4& projectionview, glm::vec3 eyeposition) {
+    m_queue = &queue;
+    m_eyeposition = eyeposition;
+    queue.set_uniforms(&m_state, [projectionview](GLShader& shader){
+        shader.set_uniform("projectionview", projectionview);
+    });
 }
 
-void VoxelRenderer::render(Entity e) const {
-    auto& chunk = e.get<Component::Chunk>();
-    auto& transform = e.get<Component::Transform>();
-    render_data.block_id->set_data(chunk.data, GLTexture::RED_INTEGER, Component::Chunk::LENGTH, Component::Chunk::LENGTH, Component::Chunk::LENGTH);
-    render_data.shader->set_uniform("model", transform.get_matrix());
-    render_data.shader->set_uniform("normalmatrix", transform.get_normalmatrix());
-    glDrawArrays(GL_POINTS, 0, Component::Chunk::SIZE);
+void VoxelRenderer::set_shadows(AbstractGLTexture& shadowmap, const glm::mat4& lightspace) {
+    AbstractGLTexture* texture = &shadowmap;
+    m_queue->set_uniforms(&m_state, [texture, lightspace](GLShader& shader){
+        shader.set_uniform("shadowmap", *texture);
+        shader.set_uniform("lightspace", lightspace);
+    });
 }
 
-void VoxelRenderer::end() const {
-    render_data.va->unbind();
-    render_data.block_id->unbind();
+void VoxelRenderer::render(Entity e) const {
+    // chunks may change or move in the registry before the queue executes
+    Component::Chunk* chunk = m_queue->allocate<Component::Chunk>(1);
+    std::memcpy(chunk, &e.get<Component::Chunk>(), sizeof(Component::Chunk));
+    auto& world = e.get<Component::WorldMatrix>();
+    glm::mat4 model = world.model;
+    glm::mat3 normal = world.normal;
+    // chunks are drawn from their corner
+    glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(0.5f * Component::Chunk::LENGTH), 1.0f));
+    float distance = glm::length(center - m_eyeposition);
+
+    // all chunks share the block_id texture, so it's filled per draw
+    GLTexture* block_id = render_data.block_id.get();
+    const GLVertexArray* va = render_data.va.get();
+    m_queue->submit(RenderQueue::GEOMETRY, &m_state, RenderQueue::depth_bits(distance), 
+        [chunk, block_id, va, model, normal](GLShader* shader){
+            block_id->set_data(chunk->data, GLTexture::RED_INTEGER, Component::Chunk::LENGTH, Component::Chunk::LENGTH, Component::Chunk::LENGTH);
+            shader->set_uniform("model", model);
+            shader->set_uniform("normalmatrix", normal);
+            va->bind();
+            glDrawArrays(GL_POINTS, 0, Component::Chunk::SIZE);
+        }
+    );
 }
 
-void VoxelRenderer::begin_shadow(glm::mat4 &projectionview) const {
-    render_data.shadow_shader->bind();
-    render_data.va->bind();
-    render_data.shadow_shader->set_uniform("block_id", *render_data.block_id);
-    render_data.shadow_shader->set_uniform("projectionview", projectionview);
+void VoxelRenderer::begin_shadow(RenderQueue& queue, const glm::mat4& projectionview) {
+    m_queue = &queue;
+    queue.set_uniforms(&m_shadow_state, [projectionview](GLShader& shader){
+        shader.set_uniform("projectionview", projectionview);
+    });
 }
 
 void VoxelRenderer::render_shadow(Entity e) const {
-    auto& chunk = e.get<Component::Chunk>();
-    auto& transform = e.get<Component::Transform>();
-    render_data.block_id->set_data(chunk.data, GLTexture::RED_INTEGER, Component::Chunk::LENGTH, Component::Chunk::LENGTH, Component::Chunk::LENGTH);
-    render_data.shadow_shader->set_uniform("model", transform.get_matrix());
-    glDrawArrays(GL_POINTS, 0, Component::Chunk::SIZE);
+    Component::Chunk* chunk = m_queue->allocate<Component::Chunk>(1);
+    std::memcpy(chunk, &e.get<Component::Chunk>(), sizeof(Component::Chunk));
+    glm::mat4 model = e.get<Component::WorldMatrix>().model;
+
+    GLTexture* block_id = render_data.block_id.get();
+    const GLVertexArray* va = render_data.va.get();
+    m_queue->submit(RenderQueue::SHADOW, &m_shadow_state, 0, 
+        [chunk, block_id, va, model](GLShader* shader){
+            block_id->set_data(chunk->data, GLTexture::RED_INTEGER, Component::Chunk::LENGTH, Component::Chunk::LENGTH, Component::Chunk::LENGTH);
+            shader->set_uniform("model", model);
+            va->bind();
+            glDrawArrays(GL_POINTS, 0, Component::Chunk::SIZE);
+        }
+    );
 }
@@ -10,6 +10,7 @@
 
 #include "Scene/Entity.hpp"
 #include "TextureAtlas.hpp"
+#include "RenderQueue.hpp"
 
 namespace Component {
     struct Chunk {
@@ -37,6 +38,8 @@ namespace Component {
     };
 }
 
+// Records draws into a RenderQueue, chunks go to the GEOMETRY pass front to
+// back and to the SHADOW pass.
 class VoxelRenderer {
 private:
     struct {
@@ -48,17 +51,23 @@ private:
         std::shared_ptr<RegularTextureAtlas> texture_map = nullptr;
     } render_data;
 
+    RenderQueue::ShaderState m_state;
+    RenderQueue::ShaderState m_shadow_state;
+
+    RenderQueue* m_queue = nullptr;
+    glm::vec3 m_eyeposition;
+
 public:
     VoxelRenderer() {}
     ~VoxelRenderer() {}
 
     void init();
-    GLShader& get_shader() { return *render_data.shader; }
 
-    void begin(glm::mat4& projectionview) const;
+    void begin(RenderQueue& queue, const glm::mat4& projectionview, glm::vec3 eyeposition);
+    // after begin()
+    void set_shadows(AbstractGLTexture& shadowmap, const glm::mat4& lightspace);
     void render(Entity e) const; 
-    void end() const;
 
-    void begin_shadow(glm::mat4& projectionview) const;
+    void begin_shadow(RenderQueue& queue, const glm::mat4& projectionview);
     void render_shadow(Entity e) const; 
 };
\ No newline at end of file
@@ -50,6 +50,7 @@ Let's consider a chunk of size C^3 and X * Y * Z chunks
 #include "opengl/GLTexture.hpp"
 
 #include "Scene/Entity.hpp"
+#include "core/JobSystem.hpp"
 #include "TextureAtlas.hpp"
 
 namespace Component {
@@ -71,22 +72,33 @@ namespace Component {
             data = new uint8_t[size.x * size.y * size.z];
             std::cout << sizeof(float) * size.x * size.y * size.z << std::endl;
             
-            for (size_t x = 0; x < size.x; x++) {
-                float xsin = sin(0.01f * x);
-
-                for (size_t y = 0; y < size.y; y++) {
-                    float yn = (3.0f * y) / size.y - 1.5f;
-                
-                    for (size_t z = 0; z < size.z; z++) {
-                        float zsin = sin(0.02f * z);
-
-                        data[z + size.z * (y + size.y * x)] = 
-                            (xsin * zsin > yn) * 
-                            static_cast<uint8_t>(rand() % 0xff);
+            // x slices are independent so we can generate them in parallel.
+            // rand() isn't thread safe so block types come from a hash instead
+            JobSystem::get().parallel_for(0, size.x, 8, [this](size_t first, size_t last){
+                for (size_t x = first; x < last; x++) {
+                    float xsin = sin(0.01f * x);
+
+                    for (size_t y = 0; y < size.y; y++) {
+                        float yn = (3.0f * y) / size.y - 1.5f;
+                    
+                        for (size_t z = 0; z < size.z; z++) {
+                            float zsin = sin(0.02f * z);
+                            size_t idx = z + size.z * (y + size.y * x);
+
+                            data[idx] = (xsin * zsin > yn) * static_cast<uint8_t>(hash(idx) % 0xff);
+                        }
                     }
                 }
-            }
+            });
+        }
 
+        static uint32_t hash(size_t x) {
+            // lowbias32
+            uint32_t h = (uint32_t) x;
+            h ^= h >> 16; h *= 0x7feb352d;
+            h ^= h >> 15; h *= 0x846ca68b;
+            h ^= h >> 16;
+            return h;
         }
     };
 }
@@ -133,7 +145,8 @@ public:
     }
     GLShader& get_shader() { return *render_data.shader; }
 
-    void begin(glm::mat4& projectionview, glm::vec3 eyeposition) const {
+    // Draws immediately, GL thread only
+    void begin(const glm::mat4& projectionview, glm::vec3 eyeposition) const {
        render_data.shader->bind();
        render_data.va->bind();
 
@@ -147,15 +160,12 @@ public:
         render_data.shader->set_uniform("ambient_color", glm::vec3(0.2f));
     };
 
-    void render(Entity e) const {
-        auto& world = e.get<Component::VoxelWorld>();
-        if (world.needs_update)
-            update_world(world);
-
+    // Draws a world of `size` with the data of the last update_world()
+    void render(glm::ivec3 size) const {
         for (int dim : {1, 0, 2}) {
-            render_data.va->update(0, get_quad(world.size, dim), 4 * 3 * sizeof(float));
+            render_data.va->update(0, get_quad(size, dim), 4 * 3 * sizeof(float));
             render_data.shader->set_uniform("dim", dim);
-            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, world.size[dim] + 1);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, size[dim] + 1);
         }
     }; 
 
@@ -164,13 +174,14 @@ public:
         render_data.block_id->unbind();
     };
 
-    void update_world(Component::VoxelWorld& world) const {
+    // Uploads VoxelWorld::data, which needs to stay alive and unchanged until
+    // this ran
+    void update_world(const uint8_t* data, glm::ivec3 size) const {
         // TODO: lazy local updates from component?
         render_data.block_id->set_data(
-            world.data, GLTexture::RED_INTEGER, 
-            world.size.x, world.size.y, world.size.z
+            const_cast<uint8_t*>(data), GLTexture::RED_INTEGER, 
+            size.x, size.y, size.z
         );
-        world.needs_update = false;
     }
 
     // void begin_shadow(glm::mat4& projectionview) const;
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <vector>
+
+#include "Scene/Entity.hpp"
+#include "Scene/Hierarchy.hpp"
+#include "Scene/TransformBatch.hpp"
+
+// Reparenting doesn't touch the Transform, the world matrix still has to
+// follow the new parent.
+
+static int s_failures = 0;
+
+static void check_position(entt::registry& registry, entt::entity e, glm::vec3 expected, const char* label) {
+    glm::vec3 position = glm::vec3(registry.get<Component::WorldMatrix>(e).model[3]);
+    if (glm::length(position - expected) > 1e-5f) {
+        std::cout << label << ": expected " << expected.x << ", " << expected.y << ", " << expected.z
+            << " got " << position.x << ", " << position.y << ", " << position.z << std::endl;
+        s_failures++;
+    }
+}
+
+int main() {
+    entt::registry registry;
+    TransformHierarchy::connect(registry);
+    TransformBatch batch;
+
+    Entity a(registry, registry.create());
+    Entity b(registry, registry.create());
+    Entity child(registry, registry.create());
+    Entity grandchild(registry, registry.create());
+    a.add<Component::Transform>(glm::vec3(1.0f, 0.0f, 0.0f));
+    b.add<Component::Transform>(glm::vec3(0.0f, 5.0f, 0.0f));
+    child.add<Component::Transform>(glm::vec3(0.0f, 0.0f, 1.0f));
+    grandchild.add<Component::Transform>(glm::vec3(0.0f, 0.0f, 1.0f));
+
+    child.set_parent(a);
+    grandchild.set_parent(child);
+    TransformHierarchy::update(registry, batch);
+    check_position(registry, child, glm::vec3(1.0f, 0.0f, 1.0f), "child of a");
+    check_position(registry, grandchild, glm::vec3(1.0f, 0.0f, 2.0f), "grandchild of a");
+
+    child.set_parent(b);
+    TransformHierarchy::update(registry, batch);
+    check_position(registry, child, glm::vec3(0.0f, 5.0f, 1.0f), "child of b");
+    check_position(registry, grandchild, glm::vec3(0.0f, 5.0f, 2.0f), "grandchild of b");
+
+    child.remove_parent();
+    TransformHierarchy::update(registry, batch);
+    check_position(registry, child, glm::vec3(0.0f, 0.0f, 1.0f), "child without parent");
+    check_position(registry, grandchild, glm::vec3(0.0f, 0.0f, 2.0f), "grandchild without grandparent");
+
+    // Deeper than any fixed number of passes, parented leaf first so the
+    // Parent storage starts out in the worst order.
+    const int DEPTH = 20;
+    std::vector<Entity> chain;
+    for (int i = 0; i < DEPTH; i++) {
+        chain.emplace_back(registry, registry.create());
+        chain.back().add<Component::Transform>(glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+    for (int i = DEPTH - 1; i > 0; i--)
+        chain[i].set_parent(chain[i - 1]);
+    chain[0].set_parent(a);
+    TransformHierarchy::update(registry, batch);
+    check_position(registry, chain.back(), glm::vec3(1.0f, 0.0f, (float) DEPTH), "end of deep chain under a");
+
+    chain[0].set_parent(b);
+    TransformHierarchy::update(registry, batch);
+    check_position(registry, chain.back(), glm::vec3(0.0f, 5.0f, (float) DEPTH), "end of deep chain under b");
+    if (registry.get<Component::Parent>(chain.back()).depth != DEPTH) {
+        std::cout << "end of deep chain: expected depth " << DEPTH << " got " << registry.get<Component::Parent>(chain.back()).depth << std::endl;
+        s_failures++;
+    }
+
+    if (s_failures == 0)
+        std::cout << "HierarchyTest passed" << std::endl;
+    return s_failures == 0 ? 0 : 1;
+}